@@ -23,8 +23,29 @@ namespace Abaco
   {
     const int STRTAB_BLOCKSZ = 256;
     const int STRIDX_PREALLOC = 32;
+    const string FUSE_ADD = "+";
+    const string FUSE_MUL = "*";
+    const string FUSE_FMA = "fma";
+    const char LITERAL = '\x01';
     static GLib.Bytes trash;
 
+    /*
+     * Rewrite 'a * b + c' into 'fma (a, b, c)'; only
+     * meaningful where such a function is registered
+     *
+     */
+
+    public bool fuse { get; set; default = false; }
+
+    /*
+     * Lift literals out of compiled code, so front ends
+     * can cache one template per expression shape (see
+     * Rules.normalize and bind)
+     *
+     */
+
+    public bool parameterize { get; set; default = false; }
+
     private interface Checkable : Section
     {
       public abstract void check ();
@@ -179,6 +200,7 @@ namespace Abaco
             opcode.code = Code.MOVE;
             opcode.a = (uint8) regs [i];
             opcode.b = (uint8) dump [i];
+            opcode.c = 1;
 
             this.put (opcode);
             stack.unalloc (dump [i]);
@@ -406,6 +428,13 @@ namespace Abaco
       return idx;
       }
 
+      public uint slot (string value)
+      {
+        var idx = stridx.length;
+        stridx.add (store.insert (value));
+      return idx;
+      }
+
       public override GLib.Bytes finish () throws GLib.Error
       {
         foreach (var str in stridx)
@@ -436,10 +465,35 @@ namespace Abaco
     private class Arguments
     {
       private GLib.HashTable<string, uint> names;
+      private GLib.HashTable<string, uint> uses;
+      private GLib.HashTable<string, uint>? lifted = null;
+      private uint[] slots;
       private uint nargs = 0;
 
       /* public API */
 
+      public void lift (string[] literals)
+      {
+        lifted = new GLib.HashTable<string, uint> (GLib.str_hash, GLib.str_equal);
+        slots = new uint [literals.length];
+
+        for (uint i = 0; i < literals.length; i++)
+        {
+          lifted.insert (literals [i], i);
+          slots [i] = uint.MAX;
+        }
+      }
+
+      public uint constant (string symbol, StrtabSection strtab)
+      {
+        uint idx = 0;
+        if (lifted == null || !lifted.lookup_extended (symbol, null, out idx))
+          return strtab.intern (symbol);
+        if (slots [idx] == uint.MAX)
+          slots [idx] = strtab.slot ("%c%u".printf (LITERAL, idx));
+      return slots [idx];
+      }
+
       public uint lookup (string key)
       {
         uint idx = 0;
@@ -448,6 +502,15 @@ namespace Abaco
       return idx;
       }
 
+      public bool release (string key)
+      {
+        uint left = 0;
+        if (!uses.lookup_extended (key, null, out left))
+          error ("Unknown variable '%s'", key);
+        uses.replace (key, --left);
+      return left == 0;
+      }
+
       public void count (Ast.Node node)
       {
         node.children_foreach (count);
@@ -458,7 +521,10 @@ namespace Abaco
           {
             var idx = nargs++;
             names.insert (key, idx);
+            uses.insert (key, 0);
           }
+
+          uses.replace (key, uses.lookup (key) + 1);
         }
       }
 
@@ -495,6 +561,7 @@ namespace Abaco
       public Arguments ()
       {
         names = new GLib.HashTable<string, uint> (GLib.str_hash, GLib.str_equal);
+        uses = new GLib.HashTable<string, uint> (GLib.str_hash, GLib.str_equal);
       }
     }
 
@@ -518,7 +585,7 @@ namespace Abaco
           reg = stack.alloc ();
           opcode.code = Code.LOADK;
           opcode.a = reg;
-          opcode.bx = strtab.intern (symbol);
+          opcode.bx = args.constant (symbol, strtab);
           code.put (opcode);
           code.push (reg);
           break;
@@ -527,37 +594,86 @@ namespace Abaco
           opcode.code = Code.MOVE;
           opcode.a = reg;
           opcode.b = args.lookup (symbol);
+          opcode.c = args.release (symbol) ? 1 : 0;
           code.put (opcode);
           code.push (reg);
           break;
         case Ast.SymbolKind.FUNCTION:
+          call (symbol, (int) node.n_children (), sections);
+          break;
+        }
+      }
+
+      public void call (string symbol, int nth, Section[] sections) throws GLib.Error
+      {
+        unowned var code = (CodeSection) sections [0];
+        unowned var stack = (StackSection) sections [1];
+        unowned var strtab = (StrtabSection) sections [3];
+        var regs = (nth > 0) ? code.prepcall (stack, nth) : null;
+        var reg = stack.alloc ();
+        var opcode = Opcode ();
+
+        opcode.code = Code.LOADF;
+        opcode.a = reg;
+        opcode.bx = strtab.intern (symbol);
+        code.put (opcode);
+
+        opcode.code = Code.CALL;
+        opcode.a = reg;
+        opcode.b = (nth > 0) ? (uint16) regs [0] : 0;
+        opcode.c = (uint16) nth;
+        code.put (opcode);
+
+        stack.unallocs (regs);
+        code.push (reg);
+      }
+
+      /*
+       * Matches 'a * b + c' (either addend order) for
+       * a single fma (a, b, c) call
+       *
+       */
+
+      static bool fusable (Ast.Node node, out unowned Ast.Node? a, out unowned Ast.Node? b, out unowned Ast.Node? c)
+      {
+        a = b = c = null;
+
+        if (node.kind != Ast.SymbolKind.FUNCTION
+          || node.symbol != FUSE_ADD
+          || node.n_children () != 2)
+          return false;
+
+        for (uint i = 0; i < 2; i++)
+        {
+          unowned var child = node.nth_child (i);
+          if (child.kind == Ast.SymbolKind.FUNCTION
+            && child.symbol == FUSE_MUL
+            && child.n_children () == 2)
           {
-            var nth = (int) node.n_children ();
-            var regs = (nth > 0) ? code.prepcall (stack, nth) : null;
-            reg = stack.alloc ();
-
-            opcode.code = Code.LOADF;
-            opcode.a = reg;
-            opcode.bx = strtab.intern (symbol);
-            code.put (opcode);
-
-            opcode.code = Code.CALL;
-            opcode.a = reg;
-            opcode.b = (nth > 0) ? (uint16) regs [0] : 0;
-            opcode.c = (uint16) nth;
-            code.put (opcode);
-
-            stack.unallocs (regs);
-            code.push (reg);
+            a = child.nth_child (0);
+            b = child.nth_child (1);
+            c = node.nth_child (1 - i);
+            return true;
           }
-          break;
         }
+      return false;
       }
 
       public void traverse (Ast.Node node)
       {
         unowned var args = (uintptr*) this;
-        node.children_foreach (traverse);
+        unowned Ast.Node? a = null, b = null, c = null;
+        var fused = args [6] != 0 && fusable (node, out a, out b, out c);
+
+        if (!fused)
+          node.children_foreach (traverse);
+        else
+        {
+          traverse (a);
+          traverse (b);
+          traverse (c);
+        }
+
         if (unlikely (args [0] != 0))
           return;
 
@@ -567,8 +683,11 @@ namespace Abaco
         {
           unowned var arguments = (Arguments) args [1];
           unowned var sections = (Section[]) & args [2];
-                      sections.length = 3;
-          compile (node, arguments, sections);
+                      sections.length = 4;
+          if (!fused)
+            compile (node, arguments, sections);
+          else
+            call (FUSE_FMA, 3, sections);
         } catch (GLib.Error e)
         {
           unowned var
@@ -579,7 +698,7 @@ namespace Abaco
       }
     }
 
-    public GLib.Bytes assemble (Ast.Node tree) throws GLib.Error
+    private GLib.Bytes emit (Ast.Node tree, string[]? literals) throws GLib.Error
     {
       var binary = new Binary ();
       var arguments = new Arguments ();
@@ -588,17 +707,20 @@ namespace Abaco
       var notes = binary.notes;
       var strtab = binary.strtab;
 
+      if (literals != null)
+        arguments.lift (literals);
       arguments.count (tree);
       arguments.alloc (stack);
 
       /* begin assemble */
 
-      uintptr args [6];
+      uintptr args [7];
       args [1] = (uintptr) arguments;
       args [2] = (uintptr) code;
       args [3] = (uintptr) stack;
       args [4] = (uintptr) notes;
       args [5] = (uintptr) strtab;
+      args [6] = (uintptr) (fuse ? 1 : 0);
       var cp = (Compiler) args;
           cp.traverse (tree);
 
@@ -633,6 +755,129 @@ namespace Abaco
     return binary.finish ();
     }
 
+    public GLib.Bytes assemble (Ast.Node tree) throws GLib.Error
+    {
+      return emit (tree, null);
+    }
+
+    /*
+     * Constants listed in 'literals' get string table
+     * slots of their own holding a placeholder, which
+     * bind () later replaces with the per-call value
+     *
+     */
+
+    public GLib.Bytes assemble_template (Ast.Node tree, string[] literals) throws GLib.Error
+    {
+      return emit (tree, literals);
+    }
+
+    [CCode (cname = "memchr", cheader_filename = "string.h")]
+    static extern uint8* memchr (void* s, int c, size_t n);
+
+    /*
+     * Placeholders are LITERAL followed by a decimal
+     * index, nothing else; -1 otherwise
+     *
+     */
+
+    static int literal_slot (string value)
+    {
+      var index = (int) 0;
+      if (value.length < 2)
+        return -1;
+
+      for (int i = 1; i < value.length; i++)
+      {
+        var c = value [i];
+        if (!c.isdigit () || index > (int.MAX - 9) / 10)
+          return -1;
+        index = index * 10 + (c - '0');
+      }
+    return index;
+    }
+
+    public static GLib.Bytes bind (GLib.Bytes template, string[] literals) throws GLib.Error
+    {
+      var sectsz = sizeof (Abaco.Bytecode.Section);
+      var align = Abaco.Bytecode.SECTION_ALIGN;
+      var binary = new Blob ();
+
+      if (literals.length == 0)
+        return template;
+
+      unowned var data = template.get_data ();
+      unowned var ptr = (uint8*) data;
+      unowned var top = ptr + data.length;
+
+      while (ptr < top)
+      {
+        unowned var section = (Abaco.Bytecode.Section*) ptr;
+        var span = (SectionFlags.VIRTUAL in section.flags) ? sectsz : (size_t) section.size;
+        var miss = span % align;
+        if (miss > 0)
+          span += align - miss;
+        if (unlikely (span > (size_t) (top - ptr)))
+          throw new ExpressionError.FAILED ("Truncated template");
+
+        if (section.type != SectionType.STRTAB
+          || SectionFlags.VIRTUAL in section.flags)
+        {
+          unowned var buffer = (uint8[]) ptr;
+                      buffer.length = (int) span;
+          binary.write_all (buffer, null);
+        }
+        else
+        {
+          var strings = new Blob ();
+          var header = *section;
+          var padding = (int) 0;
+          var last = ptr + section.size;
+          uint8* nul = null;
+
+          for (var str = ptr + sectsz; str < last; str = nul + 1)
+          {
+            if (unlikely ((nul = memchr (str, 0, (size_t) (last - str))) == null))
+              throw new ExpressionError.FAILED ("Truncated template");
+
+            unowned var value = (string) str;
+            if (value [0] == LITERAL)
+            {
+              var idx = literal_slot (value);
+              if (unlikely (idx < 0 || idx >= literals.length))
+                throw new ExpressionError.FAILED ("Unbound literal '%s'", value.offset (1).escape ());
+              value = literals [idx];
+            }
+
+            unowned var buffer = value.data;
+                        buffer.length = value.length + 1;
+            strings.write_all (buffer, null);
+          }
+
+          var bytes = strings.finish ();
+          var size = bytes.get_size () + sectsz;
+          if ((miss = size % align) > 0)
+            padding = align - (int) miss;
+
+          assert (size < (size_t) uint32.MAX);
+          header.size = (uint32) size;
+
+          binary.write_all ((uint8[]) &header, null);
+          binary.write_all (bytes.get_data (), null);
+
+          if (padding > 0)
+          {
+            unowned var buffer = trash.get_data ();
+                        buffer.length = padding;
+            binary.write_all (buffer, null);
+          }
+        }
+
+        ptr += span;
+      }
+    return binary.finish ();
+    }
+
     static construct
     {
       uint8 source [Abaco.Bytecode.SECTION_ALIGN];
@@ -15,7 +15,6 @@
  * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
  *
  */
-
 namespace Abaco.Ast
 {
   public enum SymbolKind
@@ -27,30 +26,153 @@ namespace Abaco.Ast
 
   public delegate void Foreach (Node node);
 
+  /*
+   * Nodes, their child vectors and (interned) symbols
+   * live in blocks owned by an arena (see astpatch.h),
+   * which goes away as a whole once its last reference
+   * is dropped; referencing any node references its
+   * arena.
+   *
+   */
+
+  [Compact]
+  [CCode (ref_function = "abaco_ast_node_ref", unref_function = "abaco_ast_node_unref")]
   public class Node
   {
-    private AstPatch.Chain chain;
-    private Datalist<string?> notes;
-    public SymbolKind kind { get; private set; }
-    public string symbol { get; private set; }
+    internal void* arena;
+    internal Node** children;
+    internal unowned Node? parent;
+    internal uint count;
+    internal uint size;
+    internal unowned string symbol;
+    internal SymbolKind kind;
+
+    /* private API */
 
-    public void append (Node child) { AstPatch.Chain.append (ref chain, ref child.chain); }
-    public void prepend (Node child) { AstPatch.Chain.prepend (ref chain, ref child.chain); }
-    public uint n_children () { return AstPatch.Chain.n_children (ref chain); }
-    public void children_foreach (Foreach callback) { AstPatch.Chain.foreach_data (ref chain, callback); }
+    private unowned AstPatch.Arena get_arena ()
+    {
+      return (AstPatch.Arena) arena;
+    }
 
-    public void set_note (string index, string content) { notes.set_data (index, content); }
-    public void set_note_by_id (GLib.Quark index, string content) { notes.id_set_data (index, content); }
-    public unowned string get_note (string index) { return notes.get_data (index); }
-    public unowned string get_note_by_id (GLib.Quark index) { return notes.id_get_data (index); }
-    public string steal_note (string index) { return notes.remove_no_notify (index); }
-    public string steal_note_by_id (GLib.Quark index) { return notes.id_remove_no_notify (index); }
+    private bool accepts (Node child)
+    {
+      if (child.parent != null)
+        return false;
+      for (unowned Node? node = this; node != null; node = node.parent)
+      if (node == child)
+        return false;
+    return child.arena == arena || !((AstPatch.Arena) child.arena).adopts (get_arena ());
+    }
 
-    public Node (string symbol, SymbolKind kind)
+    private void reserve (Node child)
     {
-      chain.self = this;
-      this.symbol = symbol;
-      this.kind = kind;
+      if (child.arena != arena)
+        get_arena ().adopt ((AstPatch.Arena) child.arena);
+
+      if (count == size)
+      {
+        var grown = (size == 0) ? 4 : 2 * size;
+        var vector = (Node**) get_arena ().alloc (grown * sizeof (Node*));
+
+        if (count > 0)
+          GLib.Memory.copy (vector, children, count * sizeof (Node*));
+        children = vector;
+        size = grown;
+      }
     }
+
+    internal static unowned Node alloc (AstPatch.Arena arena, string symbol, SymbolKind kind, uint n_children)
+    {
+      unowned var node = (Node) arena.alloc (sizeof (Node));
+      node.arena = (void*) arena;
+      node.symbol = arena.intern (symbol);
+      node.kind = kind;
+      node.count = n_children;
+      node.size = n_children;
+      node.children = (n_children == 0) ? null : (Node**) arena.alloc (n_children * sizeof (Node*));
+    return node;
+    }
+
+    internal void set_child (uint n, Node child)
+      requires (n < count)
+    {
+      children [n] = child;
+      child.parent = this;
+    }
+
+    /* public API */
+
+    public unowned string get_symbol () { return symbol; }
+    public SymbolKind get_kind () { return kind; }
+    public uint n_children () { return count; }
+    public unowned Node? nth_child (uint n) { return (n < count) ? (Node) children [n] : null; }
+
+    public void children_foreach (Foreach callback)
+    {
+      for (uint i = 0; i < count; i++)
+        callback ((Node) children [i]);
+    }
+
+    public unowned Node @ref ()
+    {
+      get_arena ().ref ();
+    return this;
+    }
+
+    public void unref ()
+    {
+      get_arena ().unref ();
+    }
+
+    /*
+     * Standalone nodes and in-place tree edits, kept
+     * for API compatibility: every standalone node
+     * takes an arena of its own, and linking trees
+     * from different arenas ties their lifetimes.
+     * A node can be linked under a single parent,
+     * never under its own subtree, and never from an
+     * arena which already adopted this node's one.
+     *
+     */
+
+    [Version (deprecated = true, replacement = "Rules.parse")]
+    public static Node @new (string symbol, SymbolKind kind)
+    {
+      var arena = new AstPatch.Arena ();
+    return alloc (arena, symbol, kind, 0);
+    }
+
+    [Version (deprecated = true)]
+    public void append (Node child)
+      requires (accepts (child))
+    {
+      reserve (child);
+      children [count++] = child;
+      child.parent = this;
+    }
+
+    [Version (deprecated = true)]
+    public void prepend (Node child)
+      requires (accepts (child))
+    {
+      reserve (child);
+      GLib.Memory.move (children + 1, children, count * sizeof (Node*));
+      children [0] = child;
+      child.parent = this;
+      count++;
+    }
+
+    [Version (deprecated = true)]
+    public void set_note (string index, string content) { set_note_by_id (GLib.Quark.from_string (index), content); }
+    [Version (deprecated = true)]
+    public void set_note_by_id (GLib.Quark index, string content) { get_arena ().set_note (this, index, content); }
+    [Version (deprecated = true)]
+    public unowned string get_note (string index) { return get_note_by_id (GLib.Quark.try_string (index)); }
+    [Version (deprecated = true)]
+    public unowned string get_note_by_id (GLib.Quark index) { return get_arena ().get_note (this, index); }
+    [Version (deprecated = true)]
+    public string steal_note (string index) { return steal_note_by_id (GLib.Quark.try_string (index)); }
+    [Version (deprecated = true)]
+    public string steal_note_by_id (GLib.Quark index) { return get_arena ().steal_note (this, index); }
   }
 }
@@ -21,65 +21,193 @@
 # error "Private header"
 #endif // __LIBABACO_INSIDE__
 #include <glib.h>
+#include <string.h>
 
-typedef struct _AstChain AstChain;
+typedef struct _AstArena AstArena;
+typedef struct _AstBlock AstBlock;
+
+#define AST_ARENA_BLOCKSZ (4096)
+#define AST_ARENA_ALIGN (2 * sizeof (gpointer))
+#define AST_ARENA_HEADER ((sizeof (AstBlock) + AST_ARENA_ALIGN - 1) & ~(AST_ARENA_ALIGN - 1))
 
 #if __cplusplus
 extern "C" {
 #endif // __cplusplus
 
-struct _AstChain
+/*
+ * Backing store for parse trees: nodes and their
+ * child vectors are carved out of blocks, symbols are
+ * interned in a string chunk, and everything goes at
+ * once when the last reference on the arena drops.
+ * Notes and arenas adopted through cross-tree links
+ * (see Ast.Node.append) are kept on the side.
+ *
+ */
+
+struct _AstBlock
 {
-  gpointer self;
-  AstChain* next;
-  AstChain* prev;
-  AstChain* parent;
-  AstChain* children;
+  AstBlock* next;
+  gsize size;
+  gsize used;
 };
 
-gpointer abaco_ast_node_ref (gpointer instance);
-void abaco_ast_node_unref (gpointer instance);
-
-G_STATIC_ASSERT (G_STRUCT_OFFSET (AstChain, self) == G_STRUCT_OFFSET (GNode, data));
-G_STATIC_ASSERT (G_STRUCT_OFFSET (AstChain, next) == G_STRUCT_OFFSET (GNode, next));
-G_STATIC_ASSERT (G_STRUCT_OFFSET (AstChain, prev) == G_STRUCT_OFFSET (GNode, prev));
-G_STATIC_ASSERT (G_STRUCT_OFFSET (AstChain, parent) == G_STRUCT_OFFSET (GNode, parent));
-G_STATIC_ASSERT (G_STRUCT_OFFSET (AstChain, children) == G_STRUCT_OFFSET (GNode, children));
+struct _AstArena
+{
+  AstBlock* blocks;
+  GStringChunk* symbols;
+  GHashTable* notes;
+  GPtrArray* adopted;
+};
 
 static inline void
-_ast_append (AstChain* a, AstChain* b)
+_ast_arena_clear (gpointer pself)
+{
+  AstArena* self = pself;
+  AstBlock* block;
+
+  while ((block = self->blocks) != NULL)
+  {
+    self->blocks = block->next;
+    g_free (block);
+  }
+
+  g_string_chunk_free (self->symbols);
+  g_clear_pointer (&self->notes, g_hash_table_unref);
+  g_clear_pointer (&self->adopted, g_ptr_array_unref);
+}
+
+static inline AstArena*
+_ast_arena_new (void)
+{
+  AstArena* self = g_atomic_rc_box_new0 (AstArena);
+  self->symbols = g_string_chunk_new (AST_ARENA_BLOCKSZ);
+return self;
+}
+
+static inline AstArena*
+_ast_arena_ref (AstArena* self)
 {
-  g_node_append ((GNode*) a, (GNode*) b);
-  abaco_ast_node_ref (b->self);
+  return g_atomic_rc_box_acquire (self);
 }
 
 static inline void
-_ast_prepend (AstChain* a, AstChain* b)
+_ast_arena_unref (AstArena* self)
 {
-  g_node_prepend ((GNode*) a, (GNode*) b);
-  abaco_ast_node_ref (b->self);
+  g_atomic_rc_box_release_full (self, _ast_arena_clear);
+}
+
+static inline gpointer
+_ast_arena_alloc (AstArena* self, gsize size)
+{
+  AstBlock* block = self->blocks;
+  gpointer mem;
+
+  size = (size + AST_ARENA_ALIGN - 1) & ~(AST_ARENA_ALIGN - 1);
+
+  if (block == NULL || size > block->size - block->used)
+  {
+    gsize blocksz = MAX (AST_ARENA_BLOCKSZ, size);
+
+    block = g_malloc (AST_ARENA_HEADER + blocksz);
+    block->next = self->blocks;
+    block->size = blocksz;
+    block->used = 0;
+    self->blocks = block;
+  }
+
+  mem = (guint8*) block + AST_ARENA_HEADER + block->used;
+  block->used += size;
+return memset (mem, 0, size);
 }
 
-static void
-_foreach (GNode* node, gpointer pdata)
+static inline const gchar*
+_ast_arena_intern (AstArena* self, const gchar* value)
 {
-  gpointer* data = (gpointer*) pdata;
-  GFunc func = data [0];
-  gpointer user = data [1];
-  func (node->data, user);
+  return g_string_chunk_insert_const (self->symbols, value);
+}
+
+static inline gboolean
+_ast_arena_adopts (AstArena* self, AstArena* other)
+{
+  guint i;
+
+  /*
+   * Adoption holds a reference, so an arena which
+   * (even transitively) adopted its adopter would
+   * keep both alive forever; callers check this
+   * before adopting
+   *
+   */
+
+  if (self == other)
+    return TRUE;
+  if (self->adopted != NULL)
+  for (i = 0; i < self->adopted->len; i++)
+  if (_ast_arena_adopts (g_ptr_array_index (self->adopted, i), other))
+    return TRUE;
+return FALSE;
 }
 
 static inline void
-_ast_foreach_data (AstChain* chain, GFunc func, gpointer user_data)
+_ast_arena_adopt (AstArena* self, AstArena* other)
 {
-  gpointer data [2] = { func, user_data };
-  g_node_children_foreach ((GNode*) chain, G_TRAVERSE_ALL, _foreach, data);
+  guint i;
+
+  if (self->adopted == NULL)
+    self->adopted = g_ptr_array_new_with_free_func ((GDestroyNotify) _ast_arena_unref);
+  for (i = 0; i < self->adopted->len; i++)
+  if (g_ptr_array_index (self->adopted, i) == other)
+    return;
+  g_ptr_array_add (self->adopted, _ast_arena_ref (other));
 }
 
 static inline void
-_ast_destroy (AstChain* chain)
+_ast_notes_free (gpointer pnotes)
+{
+  GData** notes = pnotes;
+  g_datalist_clear (notes);
+  g_free (notes);
+}
+
+static inline GData**
+_ast_arena_notes (AstArena* self, gconstpointer node, gboolean create)
+{
+  GData** notes = NULL;
+
+  if (self->notes == NULL)
+  {
+    if (!create)
+      return NULL;
+    self->notes = g_hash_table_new_full (NULL, NULL, NULL, _ast_notes_free);
+  }
+
+  if ((notes = g_hash_table_lookup (self->notes, node)) == NULL && create)
+  {
+    notes = g_new0 (GData*, 1);
+    g_datalist_init (notes);
+    g_hash_table_insert (self->notes, (gpointer) node, notes);
+  }
+return notes;
+}
+
+static inline void
+_ast_arena_set_note (AstArena* self, gconstpointer node, GQuark key, gchar* value)
+{
+  g_datalist_id_set_data_full (_ast_arena_notes (self, node, TRUE), key, value, g_free);
+}
+
+static inline const gchar*
+_ast_arena_get_note (AstArena* self, gconstpointer node, GQuark key)
+{
+  GData** notes = _ast_arena_notes (self, node, FALSE);
+return (notes == NULL) ? NULL : g_datalist_id_get_data (notes, key);
+}
+
+static inline gchar*
+_ast_arena_steal_note (AstArena* self, gconstpointer node, GQuark key)
 {
-  abaco_ast_node_unref (chain->self);
+  GData** notes = _ast_arena_notes (self, node, FALSE);
+return (notes == NULL) ? NULL : g_datalist_id_remove_no_notify (notes, key);
 }
 
 #if __cplusplus
@@ -105,12 +105,15 @@ struct _BNote
 /* - F(X) means Xth function (Bx)             */
 
 /* NOP                                                      */
-/* MOVE   A B     R(A) := R(B)                              */
+/* MOVE   A B C   R(A) := R(B); if (C) R(B) := nil          */
 /* LOADK  A Bx    R(A) := K(Bx)                             */
 /* LOADF  A Bx    R(A) := F(Bx)                             */
 /* CALL   A B C   R(A) := R(A)(R(B), R(B+1), ..., R(B+C-1)) */
 /* RETURN A       return R(A)                               */
 
+/* CALL consumes its arguments: R(B) to R(B+C-1) are moved  */
+/* into the callee frame and read as nil afterwards         */
+
 union _BOpcode
 {
   uint8_t code : 6;
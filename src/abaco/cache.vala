@@ -0,0 +1,226 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+namespace Abaco
+{
+  /*
+   * Bounded LRU map from source text to compiled
+   * code. Every entry remembers the generation it was
+   * compiled under (see Rules.generation); a lookup
+   * under a different one drops it, so callers never
+   * see code assembled against stale rules.
+   *
+   */
+
+  public sealed class Cache : GLib.Object
+  {
+    const ulong OVERHEAD = 64;
+    private HashTable<GLib.Bytes, Entry> entries;
+    private unowned Entry? head = null;
+    private unowned Entry? tail = null;
+    private uint _capacity = 256;
+    private ulong _max_memory = 4 << 20;
+    private ulong _memory = 0;
+    private uint _hits = 0;
+    private uint _misses = 0;
+
+  /*
+   * properties
+   *
+   */
+
+    public uint capacity
+    {
+      get { return _capacity; }
+      set { _capacity = value; trim (); }
+    }
+
+    public ulong max_memory
+    {
+      get { return _max_memory; }
+      set { _max_memory = value; trim (); }
+    }
+
+    public uint length { get { return entries.size (); } }
+    public ulong memory { get { return _memory; } }
+    public uint hits { get { return _hits; } }
+    public uint misses { get { return _misses; } }
+
+  /*
+   * types
+   *
+   */
+
+    [Compact]
+    class Entry
+    {
+      public GLib.Bytes source;
+      public GLib.Bytes code;
+      public GLib.Closure? closure;
+      public uint generation;
+      public ulong size;
+      public unowned Entry? prev;
+      public unowned Entry? next;
+    }
+
+  /*
+   * private API
+   *
+   */
+
+    private void unlink (Entry entry)
+    {
+      if (entry.prev != null)
+        entry.prev.next = entry.next;
+      else
+        head = entry.next;
+      if (entry.next != null)
+        entry.next.prev = entry.prev;
+      else
+        tail = entry.prev;
+      entry.prev = null;
+      entry.next = null;
+    }
+
+    private void push (Entry entry)
+    {
+      entry.prev = null;
+      entry.next = head;
+      if (head != null)
+        head.prev = entry;
+      else
+        tail = entry;
+      head = entry;
+    }
+
+    private void drop (Entry entry)
+    {
+      unlink (entry);
+      _memory -= entry.size;
+      entries.remove (entry.source);
+    }
+
+    private void trim ()
+    {
+      while (tail != null && (entries.size () > _capacity || _memory > _max_memory))
+        drop (tail);
+    }
+
+    private unowned Entry? find (GLib.Bytes source, uint generation, bool closure = false)
+    {
+      unowned var entry = entries.lookup (source);
+
+      if (entry != null && entry.generation != generation)
+      {
+        drop (entry);
+        entry = null;
+      }
+
+      /* a bytecode-only entry does not satisfy a closure lookup */
+      if (entry == null || (closure && entry.closure == null))
+      {
+        ++_misses;
+        entry = null;
+      }
+      else
+      {
+        ++_hits;
+        if (entry != head)
+        {
+          unlink (entry);
+          push (entry);
+        }
+      }
+    return entry;
+    }
+
+  /*
+   * public API
+   *
+   */
+
+    public GLib.Bytes? lookup (GLib.Bytes source, uint generation)
+    {
+      unowned var entry = find (source, generation);
+    return (entry == null) ? null : entry.code;
+    }
+
+    public GLib.Closure? lookup_closure (GLib.Bytes source, uint generation)
+    {
+      unowned var entry = find (source, generation, true);
+    return (entry == null) ? null : entry.closure;
+    }
+
+    public void insert (GLib.Bytes source, uint generation, GLib.Bytes code, GLib.Closure? closure = null)
+    {
+      var size = (ulong) (source.get_size () + code.get_size ()) + OVERHEAD;
+      unowned var old = entries.lookup (source);
+
+      if (old != null)
+        drop (old);
+      if (_capacity == 0 || size > _max_memory)
+        return;
+
+      /*
+       * Sources may be static views over caller
+       * memory (see VM.loadstring), so keys are
+       * always private copies.
+       *
+       */
+
+      var entry = new Entry ();
+      entry.source = new GLib.Bytes (source.get_data ());
+      entry.code = code;
+      entry.closure = closure;
+      entry.generation = generation;
+      entry.size = size;
+
+      unowned var link = entry;
+      entries.insert (entry.source, (owned) entry);
+      _memory += size;
+      push (link);
+      trim ();
+    }
+
+    public void clear ()
+    {
+      head = null;
+      tail = null;
+      entries.remove_all ();
+      _memory = 0;
+    }
+
+    public void reset_counters ()
+    {
+      _hits = 0;
+      _misses = 0;
+    }
+
+    /* Constructors */
+
+    construct
+    {
+      entries = new HashTable<GLib.Bytes, Entry> (GLib.Bytes.hash, GLib.Bytes.equal);
+    }
+
+    public Cache ()
+    {
+      Object ();
+    }
+  }
+}
@@ -0,0 +1,1000 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <lexer.h>
+#include <string.h>
+
+typedef struct _Automaton Automaton;
+typedef struct _Compiler Compiler;
+typedef struct _LexFrag LexFrag;
+typedef struct _LexNode LexNode;
+typedef struct _LexSet LexSet;
+typedef struct _LexState LexState;
+
+#define LEX_DEAD (0)
+#define LEX_MAX_STATES (1024)
+
+/*
+ * Rules are compiled into Thompson automata, which
+ * are turned deterministic lazily (a state at a time,
+ * as the input asks for it) and memoized. Only plain
+ * regular syntax is understood: literals, '.', classes
+ * (\d, \w, \s, \p{L}, \p{N} and their negations),
+ * groups, alternation and the '*', '+' and '?'
+ * quantifiers; anything else makes the rule (and
+ * hence the lexer) unusable, and callers are expected
+ * to fall back to GRegex
+ *
+ */
+
+typedef enum
+{
+  LEX_NODE_SET,
+  LEX_NODE_EPSILON,
+  LEX_NODE_MATCH,
+} LexNodeKind;
+
+typedef enum
+{
+  LEX_PROP_LETTER = (1 << 0),
+  LEX_PROP_NUMBER = (1 << 1),
+  LEX_PROP_NONLETTER = (1 << 2),
+  LEX_PROP_NONNUMBER = (1 << 3),
+} LexProp;
+
+struct _LexSet
+{
+  guint32 ascii [4];
+  GArray* ranges;
+  guint props;
+  gboolean negated;
+};
+
+struct _LexNode
+{
+  LexNodeKind kind;
+  gint out;
+  gint out1;
+  gint arg;
+};
+
+struct _LexFrag
+{
+  gint start;
+  GArray* outs;
+};
+
+struct _LexState
+{
+  gint* nodes;
+  guint n_nodes;
+  gint accept;
+  gint next [128];
+  GHashTable* wide;
+};
+
+struct _Automaton
+{
+  GArray* nodes;
+  GArray* sets;
+  GArray* starts;
+  GArray* scratch;
+  GPtrArray* states;
+  GHashTable* index;
+  guint* marks;
+  guint mark;
+  gint any;
+  gint root;
+  gint initial;
+  gboolean search;
+};
+
+struct _Compiler
+{
+  Automaton* automaton;
+  const gchar* p;
+};
+
+struct _Lexer
+{
+  Automaton tokens;
+  Automaton classes;
+};
+
+/*
+ * Character sets
+ *
+ */
+
+static inline gboolean
+_prop_number (gunichar c)
+{
+  switch (g_unichar_type (c))
+  {
+  case G_UNICODE_DECIMAL_NUMBER:
+  case G_UNICODE_LETTER_NUMBER:
+  case G_UNICODE_OTHER_NUMBER:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+static inline gboolean
+_prop_test (guint props, gunichar c)
+{
+  if ((props & LEX_PROP_LETTER) && g_unichar_isalpha (c))
+    return TRUE;
+  if ((props & LEX_PROP_NONLETTER) && !g_unichar_isalpha (c))
+    return TRUE;
+  if ((props & LEX_PROP_NUMBER) && _prop_number (c))
+    return TRUE;
+  if ((props & LEX_PROP_NONNUMBER) && !_prop_number (c))
+    return TRUE;
+return FALSE;
+}
+
+static void
+_set_clear (gpointer pset)
+{
+  LexSet* set = pset;
+  if (set->ranges != NULL)
+    g_array_unref (set->ranges);
+}
+
+static void
+_set_range (LexSet* set, gunichar lo, gunichar hi)
+{
+  for (; lo <= hi && lo < 128; lo++)
+    set->ascii [lo >> 5] |= 1u << (lo & 31);
+
+  if (lo <= hi)
+  {
+    if (set->ranges == NULL)
+      set->ranges = g_array_new (FALSE, FALSE, sizeof (gunichar));
+    g_array_append_val (set->ranges, lo);
+    g_array_append_val (set->ranges, hi);
+  }
+}
+
+static void
+_set_prop (LexSet* set, guint prop)
+{
+  gunichar c;
+
+  set->props |= prop;
+  for (c = 0; c < 128; c++)
+  if (_prop_test (prop, c))
+    set->ascii [c >> 5] |= 1u << (c & 31);
+}
+
+static void
+_set_ascii (LexSet* set, gchar kind, gboolean invert)
+{
+  gunichar c;
+
+  /* \d, \w and \s are ASCII only, as in PCRE */
+  for (c = 0; c < 128; c++)
+  {
+    gboolean in;
+
+    switch (kind)
+    {
+    case 'd':
+      in = g_ascii_isdigit (c);
+      break;
+    case 'w':
+      in = g_ascii_isalnum (c) || c == '_';
+      break;
+    default:
+      in = c == ' ' || (c >= '\t' && c <= '\r');
+      break;
+    }
+
+    if (in != invert)
+      set->ascii [c >> 5] |= 1u << (c & 31);
+  }
+
+  if (invert)
+    _set_range (set, 0x80, 0x10ffff);
+}
+
+static gboolean
+_set_contains (const LexSet* set, gunichar c)
+{
+  gboolean found = FALSE;
+  guint i;
+
+  if (c < 128)
+    found = (set->ascii [c >> 5] >> (c & 31)) & 1;
+  else
+  {
+    if (set->ranges != NULL)
+    for (i = 0; i < set->ranges->len && !found; i += 2)
+      found = c >= g_array_index (set->ranges, gunichar, i)
+           && c <= g_array_index (set->ranges, gunichar, i + 1);
+    if (!found)
+      found = _prop_test (set->props, c);
+  }
+return found != set->negated;
+}
+
+/*
+ * Thompson construction
+ *
+ */
+
+static gint
+_node (Automaton* self, LexNodeKind kind, gint out, gint out1, gint arg)
+{
+  LexNode node = { kind, out, out1, arg };
+  g_array_append_val (self->nodes, node);
+return self->nodes->len - 1;
+}
+
+static gint
+_set (Automaton* self, LexSet* set)
+{
+  g_array_append_vals (self->sets, set, 1);
+return self->sets->len - 1;
+}
+
+static gint
+_set_any (Automaton* self)
+{
+  if (self->any < 0)
+  {
+    LexSet set = {0};
+    set.negated = TRUE;
+    self->any = _set (self, &set);
+  }
+return self->any;
+}
+
+static inline void
+_frag_init (LexFrag* frag, gint start, guint slot)
+{
+  frag->start = start;
+  frag->outs = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_array_append_val (frag->outs, slot);
+}
+
+static inline void
+_frag_clear (LexFrag* frag)
+{
+  g_array_unref (frag->outs);
+}
+
+static void
+_frag_patch (Automaton* self, LexFrag* frag, gint target)
+{
+  guint i, slot;
+
+  /* dangling edges are (node << 1 | which) */
+  for (i = 0; i < frag->outs->len; i++)
+  {
+    slot = g_array_index (frag->outs, guint, i);
+    LexNode* node = & g_array_index (self->nodes, LexNode, slot >> 1);
+
+    if (slot & 1)
+      node->out1 = target;
+    else
+      node->out = target;
+  }
+
+  g_array_set_size (frag->outs, 0);
+}
+
+static gboolean
+_escape_literal (const gchar** p, gunichar* ch)
+{
+  gchar c = **p;
+
+  switch (c)
+  {
+  case 'n': *ch = '\n'; break;
+  case 't': *ch = '\t'; break;
+  case 'r': *ch = '\r'; break;
+  case 'f': *ch = '\f'; break;
+  case 'v': *ch = '\v'; break;
+  default:
+    if (c == 0 || (guchar) c >= 128 || g_ascii_isalnum (c))
+      return FALSE;
+    *ch = c;
+    break;
+  }
+
+  (*p)++;
+return TRUE;
+}
+
+static gboolean
+_escape_class (const gchar** p, LexSet* set)
+{
+  const gchar* q = *p;
+  gboolean invert;
+  guint prop;
+
+  switch (*q)
+  {
+  case 'd': case 'D':
+  case 'w': case 'W':
+  case 's': case 'S':
+    invert = g_ascii_isupper (*q);
+    _set_ascii (set, g_ascii_tolower (*q), invert);
+    *p = q + 1;
+    return TRUE;
+  case 'p': case 'P':
+    invert = (*q == 'P');
+    if (q [1] != '{')
+      return FALSE;
+
+    switch (q [2])
+    {
+    case 'L':
+      prop = invert ? LEX_PROP_NONLETTER : LEX_PROP_LETTER;
+      break;
+    case 'N':
+      prop = invert ? LEX_PROP_NONNUMBER : LEX_PROP_NUMBER;
+      break;
+    default:
+      return FALSE;
+    }
+
+    if (q [3] != '}')
+      return FALSE;
+
+    _set_prop (set, prop);
+    *p = q + 4;
+    return TRUE;
+  }
+return FALSE;
+}
+
+static gboolean
+_compile_class (Compiler* self, LexSet* set)
+{
+  gboolean first = TRUE;
+  gunichar lo, hi;
+
+  if (*self->p == '^')
+  {
+    set->negated = TRUE;
+    self->p++;
+  }
+
+  for (;; first = FALSE)
+  {
+    if (*self->p == 0)
+      return FALSE;
+    if (*self->p == ']' && !first)
+      break;
+    if (self->p [0] == '[' && self->p [1] == ':')
+      return FALSE;
+
+    if (*self->p != '\\')
+    {
+      lo = g_utf8_get_char (self->p);
+      self->p = g_utf8_next_char (self->p);
+    }
+    else
+    {
+      self->p++;
+      if (_escape_class (&self->p, set))
+        continue;
+      if (!_escape_literal (&self->p, &lo))
+        return FALSE;
+    }
+
+    if (self->p [0] != '-' || self->p [1] == ']' || self->p [1] == 0)
+      _set_range (set, lo, lo);
+    else
+    {
+      self->p++;
+      if (*self->p != '\\')
+      {
+        hi = g_utf8_get_char (self->p);
+        self->p = g_utf8_next_char (self->p);
+      }
+      else
+      {
+        self->p++;
+        if (!_escape_literal (&self->p, &hi))
+          return FALSE;
+      }
+
+      if (hi < lo)
+        return FALSE;
+      _set_range (set, lo, hi);
+    }
+  }
+
+  self->p++;
+return TRUE;
+}
+
+static gboolean
+_compile_alt (Compiler* self, LexFrag* frag);
+
+static gboolean
+_compile_atom (Compiler* self, LexFrag* frag)
+{
+  Automaton* automaton = self->automaton;
+  LexSet set = {0};
+  gunichar ch;
+  gint node;
+
+  switch (*self->p)
+  {
+  case '(':
+    self->p++;
+    if (self->p [0] == '?')
+    {
+      if (self->p [1] != ':')
+        return FALSE;
+      self->p += 2;
+    }
+
+    if (!_compile_alt (self, frag))
+      return FALSE;
+    if (*self->p != ')')
+    {
+      _frag_clear (frag);
+      return FALSE;
+    }
+
+    self->p++;
+    return TRUE;
+  case '[':
+    self->p++;
+    if (!_compile_class (self, &set))
+    {
+      _set_clear (&set);
+      return FALSE;
+    }
+    break;
+  case '.':
+    self->p++;
+    set.negated = TRUE;
+    _set_range (&set, '\n', '\n');
+    break;
+  case '\\':
+    self->p++;
+    if (_escape_literal (&self->p, &ch))
+      _set_range (&set, ch, ch);
+    else
+    if (!_escape_class (&self->p, &set))
+      return FALSE;
+    break;
+  case '^': case '$':
+  case '*': case '+':
+  case '?': case '{':
+    return FALSE;
+  default:
+    ch = g_utf8_get_char (self->p);
+    self->p = g_utf8_next_char (self->p);
+    _set_range (&set, ch, ch);
+    break;
+  }
+
+  node = _node (automaton, LEX_NODE_SET, -1, -1, _set (automaton, &set));
+  _frag_init (frag, node, node << 1);
+return TRUE;
+}
+
+static gboolean
+_compile_rep (Compiler* self, LexFrag* frag)
+{
+  Automaton* automaton = self->automaton;
+  gint node;
+  gchar q;
+
+  if (!_compile_atom (self, frag))
+    return FALSE;
+  if ((q = *self->p) == '*' || q == '+' || q == '?')
+  {
+    self->p++;
+    node = _node (automaton, LEX_NODE_EPSILON, frag->start, -1, 0);
+
+    if (q != '?')
+      _frag_patch (automaton, frag, node);
+    if (q != '+')
+      frag->start = node;
+
+    node = node << 1 | 1;
+    g_array_append_val (frag->outs, node);
+  }
+
+  /* no lazy, possessive, stacked or counted repeats */
+  if ((q = *self->p) == '*' || q == '+' || q == '?' || q == '{')
+  {
+    _frag_clear (frag);
+    return FALSE;
+  }
+return TRUE;
+}
+
+static gboolean
+_compile_cat (Compiler* self, LexFrag* frag)
+{
+  Automaton* automaton = self->automaton;
+  gboolean empty = TRUE;
+  LexFrag next;
+  gint node;
+
+  while (*self->p != 0 && *self->p != '|' && *self->p != ')')
+  {
+    if (!_compile_rep (self, &next))
+    {
+      if (!empty)
+        _frag_clear (frag);
+      return FALSE;
+    }
+
+    if (empty)
+      *frag = next;
+    else
+    {
+      _frag_patch (automaton, frag, next.start);
+      _frag_clear (frag);
+      frag->outs = next.outs;
+    }
+
+    empty = FALSE;
+  }
+
+  if (empty)
+  {
+    node = _node (automaton, LEX_NODE_EPSILON, -1, -1, 0);
+    _frag_init (frag, node, node << 1);
+  }
+return TRUE;
+}
+
+static gboolean
+_compile_alt (Compiler* self, LexFrag* frag)
+{
+  Automaton* automaton = self->automaton;
+  LexFrag next;
+
+  if (!_compile_cat (self, frag))
+    return FALSE;
+
+  while (*self->p == '|')
+  {
+    self->p++;
+    if (!_compile_cat (self, &next))
+    {
+      _frag_clear (frag);
+      return FALSE;
+    }
+
+    frag->start = _node (automaton, LEX_NODE_EPSILON, frag->start, next.start, 0);
+    g_array_append_vals (frag->outs, next.outs->data, next.outs->len);
+    _frag_clear (&next);
+  }
+return TRUE;
+}
+
+/*
+ * Subset construction
+ *
+ */
+
+static guint
+_state_hash (gconstpointer pstate)
+{
+  const LexState* state = pstate;
+  guint i, hash = state->n_nodes;
+
+  for (i = 0; i < state->n_nodes; i++)
+    hash = hash * 31 + state->nodes [i];
+return hash;
+}
+
+static gboolean
+_state_equal (gconstpointer pstate1, gconstpointer pstate2)
+{
+  const LexState* state1 = pstate1;
+  const LexState* state2 = pstate2;
+return state1->n_nodes == state2->n_nodes
+    && memcmp (state1->nodes, state2->nodes, state1->n_nodes * sizeof (gint)) == 0;
+}
+
+static void
+_state_free (gpointer pstate)
+{
+  LexState* state = pstate;
+
+  if (state->wide != NULL)
+    g_hash_table_unref (state->wide);
+  g_free (state->nodes);
+  g_slice_free (LexState, state);
+}
+
+static gint
+_compare (gconstpointer a, gconstpointer b)
+{
+  return *(const gint*) a - *(const gint*) b;
+}
+
+static void
+_closure (Automaton* self, GArray* list, gint index)
+{
+  const LexNode* node;
+
+  while (index >= 0 && self->marks [index] != self->mark)
+  {
+    self->marks [index] = self->mark;
+    node = & g_array_index (self->nodes, LexNode, index);
+
+    switch (node->kind)
+    {
+    case LEX_NODE_SET:
+      g_array_append_val (list, index);
+      return;
+    case LEX_NODE_MATCH:
+      g_array_append_val (list, index);
+      break;
+    case LEX_NODE_EPSILON:
+      _closure (self, list, node->out1);
+      break;
+    }
+
+    index = node->out;
+  }
+}
+
+static void
+_closure_begin (Automaton* self)
+{
+  g_array_set_size (self->scratch, 0);
+
+  if (G_UNLIKELY (++self->mark == 0))
+  {
+    memset (self->marks, 0, sizeof (guint) * self->nodes->len);
+    self->mark = 1;
+  }
+}
+
+static gint
+_state_intern (Automaton* self)
+{
+  GArray* list = self->scratch;
+  LexState key, *state;
+  gpointer found;
+  guint i;
+
+  g_array_sort (list, _compare);
+  key.nodes = (gint*) list->data;
+  key.n_nodes = list->len;
+
+  if ((found = g_hash_table_lookup (self->index, &key)) != NULL)
+    return GPOINTER_TO_INT (found) - 1;
+
+  state = g_slice_new (LexState);
+  state->nodes = g_new (gint, list->len);
+  state->n_nodes = list->len;
+  state->accept = -1;
+  state->wide = NULL;
+
+  for (i = 0; i < 128; i++)
+    state->next [i] = -1;
+  for (i = 0; i < list->len; i++)
+  {
+    const LexNode* node;
+    state->nodes [i] = g_array_index (list, gint, i);
+    node = & g_array_index (self->nodes, LexNode, state->nodes [i]);
+
+    if (node->kind == LEX_NODE_MATCH
+      && (state->accept < 0 || node->arg < state->accept))
+      state->accept = node->arg;
+  }
+
+  g_ptr_array_add (self->states, state);
+  g_hash_table_insert (self->index, state, GINT_TO_POINTER (self->states->len));
+return self->states->len - 1;
+}
+
+static gint
+_step (Automaton* self, gint index, gunichar c)
+{
+  LexState* state = g_ptr_array_index (self->states, index);
+  const LexNode* node;
+  gpointer found;
+  gint next;
+  guint i;
+
+  if (c < 128)
+  {
+    if ((next = state->next [c]) >= 0)
+      return next;
+  }
+  else
+  if (state->wide != NULL
+    && (found = g_hash_table_lookup (state->wide, GUINT_TO_POINTER (c))) != NULL)
+    return GPOINTER_TO_INT (found) - 1;
+
+  _closure_begin (self);
+
+  for (i = 0; i < state->n_nodes; i++)
+  {
+    node = & g_array_index (self->nodes, LexNode, state->nodes [i]);
+    if (node->kind == LEX_NODE_SET
+      && _set_contains (& g_array_index (self->sets, LexSet, node->arg), c))
+      _closure (self, self->scratch, node->out);
+  }
+
+  next = _state_intern (self);
+
+  if (c < 128)
+    state->next [c] = next;
+  else
+  {
+    if (state->wide == NULL)
+      state->wide = g_hash_table_new (NULL, NULL);
+    g_hash_table_insert (state->wide, GUINT_TO_POINTER (c), GINT_TO_POINTER (next + 1));
+  }
+return next;
+}
+
+static inline gint
+_accept (Automaton* self, gint index)
+{
+  return ((LexState*) g_ptr_array_index (self->states, index))->accept;
+}
+
+/*
+ * Automata
+ *
+ */
+
+static void
+_automaton_init (Automaton* self, gboolean search)
+{
+  self->nodes = g_array_new (FALSE, FALSE, sizeof (LexNode));
+  self->sets = g_array_new (FALSE, FALSE, sizeof (LexSet));
+  self->starts = g_array_new (FALSE, FALSE, sizeof (gint));
+  self->scratch = g_array_new (FALSE, FALSE, sizeof (gint));
+  self->states = g_ptr_array_new_with_free_func (_state_free);
+  self->index = g_hash_table_new (_state_hash, _state_equal);
+  self->marks = NULL;
+  self->mark = 0;
+  self->any = -1;
+  self->root = -1;
+  self->initial = -1;
+  self->search = search;
+
+  g_array_set_clear_func (self->sets, _set_clear);
+}
+
+static void
+_automaton_clear (Automaton* self)
+{
+  g_array_unref (self->nodes);
+  g_array_unref (self->sets);
+  g_array_unref (self->starts);
+  g_array_unref (self->scratch);
+  g_ptr_array_unref (self->states);
+  g_hash_table_unref (self->index);
+  g_free (self->marks);
+}
+
+static void
+_automaton_flush (Automaton* self)
+{
+  g_hash_table_remove_all (self->index);
+  g_ptr_array_set_size (self->states, 0);
+  self->initial = -1;
+}
+
+static gboolean
+_automaton_add (Automaton* self, const gchar* pattern)
+{
+  Compiler compiler = { self, pattern };
+  LexFrag frag;
+  gint match, loop;
+
+  if (!_compile_alt (&compiler, &frag))
+    return FALSE;
+  if (*compiler.p != 0)
+  {
+    _frag_clear (&frag);
+    return FALSE;
+  }
+
+  match = _node (self, LEX_NODE_MATCH, -1, -1, self->starts->len);
+  _frag_patch (self, &frag, match);
+  _frag_clear (&frag);
+
+  /* searching rules match anywhere, so they stay matched */
+  if (self->search)
+  {
+    loop = _node (self, LEX_NODE_SET, match, -1, _set_any (self));
+    g_array_index (self->nodes, LexNode, match).out = loop;
+  }
+
+  g_array_append_val (self->starts, frag.start);
+  g_clear_pointer (&self->marks, g_free);
+  _automaton_flush (self);
+  self->root = -1;
+return TRUE;
+}
+
+static void
+_automaton_seal (Automaton* self)
+{
+  gint i, loop;
+
+  if (self->states->len > LEX_MAX_STATES)
+    _automaton_flush (self);
+
+  if (self->root < 0)
+  {
+    /* rules are tried in order, so the root is a chain */
+    for (i = self->starts->len - 1; i >= 0; i--)
+      self->root = _node (self, LEX_NODE_EPSILON, g_array_index (self->starts, gint, i), self->root, 0);
+
+    if (self->search)
+    {
+      loop = _node (self, LEX_NODE_SET, -1, -1, _set_any (self));
+      self->root = _node (self, LEX_NODE_EPSILON, self->root, loop, 0);
+      g_array_index (self->nodes, LexNode, loop).out = self->root;
+    }
+
+    self->marks = g_new0 (guint, self->nodes->len);
+    self->mark = 0;
+  }
+
+  if (self->initial < 0)
+  {
+    /* an empty set interns first, as LEX_DEAD */
+    _closure_begin (self);
+    _state_intern (self);
+
+    _closure_begin (self);
+    _closure (self, self->scratch, self->root);
+    self->initial = _state_intern (self);
+  }
+}
+
+static gsize
+_longest (Lexer* self, const gchar* input, gsize length, gint* klass)
+{
+  Automaton* tokens = & self->tokens;
+  Automaton* classes = & self->classes;
+  gint tstate = tokens->initial;
+  gint cstate = classes->initial;
+  gsize i = 0, last = 0, width;
+  gint accept, best = G_MAXINT;
+  gunichar c;
+
+  while (i < length)
+  {
+    if ((guchar) input [i] < 128)
+    {
+      c = input [i];
+      width = 1;
+    }
+    else
+    {
+      c = g_utf8_get_char (input + i);
+      width = g_utf8_next_char (input + i) - (input + i);
+    }
+
+    if ((tstate = _step (tokens, tstate, c)) == LEX_DEAD)
+      break;
+    if (klass != NULL)
+      cstate = _step (classes, cstate, c);
+
+    i += width;
+
+    /* a rule ahead in priority wins, whatever the length */
+    if ((accept = _accept (tokens, tstate)) >= 0 && accept <= best)
+    {
+      best = accept;
+      last = i;
+      if (klass != NULL)
+        *klass = _accept (classes, cstate);
+    }
+  }
+return last;
+}
+
+static gint
+_classify (Lexer* self, const gchar* input, gsize length)
+{
+  Automaton* classes = & self->classes;
+  const gchar* top = input + length;
+  gint cstate = classes->initial;
+
+  for (; input < top; input = g_utf8_next_char (input))
+    cstate = _step (classes, cstate, g_utf8_get_char (input));
+return _accept (classes, cstate);
+}
+
+/*
+ * Public API
+ *
+ */
+
+Lexer*
+_lexer_new (void)
+{
+  Lexer* self = g_slice_new (Lexer);
+  _automaton_init (& self->tokens, FALSE);
+  _automaton_init (& self->classes, TRUE);
+return self;
+}
+
+void
+_lexer_free (Lexer* self)
+{
+  _automaton_clear (& self->tokens);
+  _automaton_clear (& self->classes);
+  g_slice_free (Lexer, self);
+}
+
+gboolean
+_lexer_add_token (Lexer* self, const gchar* pattern)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (pattern != NULL, FALSE);
+return _automaton_add (& self->tokens, pattern);
+}
+
+gboolean
+_lexer_add_class (Lexer* self, const gchar* pattern)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (pattern != NULL, FALSE);
+return _automaton_add (& self->classes, pattern);
+}
+
+gsize
+_lexer_next (Lexer* self, const gchar* input, gsize length, gint* klass)
+{
+  g_return_val_if_fail (self != NULL, 0);
+  g_return_val_if_fail (klass != NULL, 0);
+  gsize size;
+
+  /*
+   * Tokens are the longest prefix matched by the
+   * first token rule (in priority order) matching
+   * any prefix at all, and their class the first
+   * class rule found anywhere in them (as GRegex
+   * searches would do), both worked out in the same
+   * pass. Runs no token rule matches become one token.
+   *
+   */
+
+  if (length == 0)
+    return 0;
+
+  _automaton_seal (& self->tokens);
+  _automaton_seal (& self->classes);
+
+  if ((size = _longest (self, input, length, klass)) == 0)
+  {
+    do
+      size = g_utf8_next_char (input + size) - input;
+    while (size < length && _longest (self, input + size, length - size, NULL) == 0);
+    *klass = _classify (self, input, size);
+  }
+return size;
+}
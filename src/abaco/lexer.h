@@ -0,0 +1,46 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __LEXER__
+#define __LEXER__ 1
+#ifndef __LIBABACO_INSIDE__
+# error "Private header"
+#endif // __LIBABACO_INSIDE__
+#include <glib.h>
+
+typedef struct _Lexer Lexer;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+G_GNUC_INTERNAL Lexer*
+_lexer_new (void);
+G_GNUC_INTERNAL void
+_lexer_free (Lexer* lexer);
+G_GNUC_INTERNAL gboolean
+_lexer_add_token (Lexer* lexer, const gchar* pattern);
+G_GNUC_INTERNAL gboolean
+_lexer_add_class (Lexer* lexer, const gchar* pattern);
+G_GNUC_INTERNAL gsize
+_lexer_next (Lexer* lexer, const gchar* input, gsize length, gint* klass);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __LEXER__
@@ -21,8 +21,10 @@ namespace Abaco
 {
   internal class Parser
   {
-    Queue<Ast.Node> output = new Queue<Ast.Node> ();
-    Queue<Symbol> operators = new Queue<Symbol> ();
+    AstPatch.Arena arena = new AstPatch.Arena ();
+    Queue<unowned Ast.Node> output = new Queue<unowned Ast.Node> ();
+    Symbol[] operators = new Symbol [16];
+    int n_operators = 0;
     Queue<uint> args = new Queue<uint> ();
     unowned SymbolClass? pklass = null;
     unowned string ptoken = null;
@@ -30,24 +32,25 @@ namespace Abaco
     const Ast.SymbolKind otypr = Ast.SymbolKind.FUNCTION;
     public bool code_strict { get; set; }
 
-    [Compact]
-    class Symbol
+    struct Symbol
     {
       public unowned string token;
       public unowned SymbolClass? klass;
       public SymbolKind kind;
+    }
 
-      public Symbol (string token, SymbolClass? klass)
-      {
-        this.token = token;
-        this.klass = klass;
-        this.kind = klass.kind;
-      }
+    void pushsym (string token, SymbolClass? klass)
+    {
+      if (n_operators == operators.length)
+        operators.resize (2 * operators.length);
+      operators [n_operators].token = token;
+      operators [n_operators].klass = klass;
+      operators [n_operators].kind = klass.kind;
+      ++n_operators;
     }
 
-    void pushsym (string token, SymbolClass? klass) { operators.push_head (new Symbol (token, klass)); }
-    unowned Symbol? peeksym () { return operators.peek_head (); }
-    void popsym () { operators.pop_head (); }
+    Symbol* peeksym () { return (n_operators > 0) ? &operators [n_operators - 1] : null; }
+    void popsym () { --n_operators; }
 
     void pushvar (string token, bool variable) throws GLib.Error
     {
@@ -76,17 +79,17 @@ namespace Abaco
       else
       {
         var kind = (variable) ? Ast.SymbolKind.VARIABLE : Ast.SymbolKind.CONSTANT;
-        var node = new Ast.Node (token, kind);
+        unowned var node = Ast.Node.alloc (arena, token, kind, 0);
         output.push_head (node);
       }
     }
 
     void pushfunction (string token, uint n_args) throws GLib.Error
     {
-      var node = new Ast.Node (token, otypr);
-      var child = (Ast.Node) null;
+      unowned var node = Ast.Node.alloc (arena, token, otypr, n_args);
+      unowned var child = (Ast.Node) null;
 
-      for (int i = 0; i < n_args; i++)
+      for (uint i = n_args; i > 0; i--)
       {
         child = output.pop_head ();
         if (child == null)
@@ -95,7 +98,7 @@ namespace Abaco
           throw new ExpressionError.FAILED (msg);
         }
 
-        node.prepend (child);
+        node.set_child (i - 1, child);
       }
 
       output.push_head (node);
@@ -119,25 +122,25 @@ namespace Abaco
       {
         while (true)
         {
-          unowned var sym = peeksym ();
+          var sym = peeksym ();
           if (sym == null)
           {
             var msg = ("unmatched '(' parenthesis").printf ();
             throw new ExpressionError.UNMATCHED_PARENTHESIS (msg);
           }
           else
-          if (sym.kind == SymbolKind.PARENTHESIS)
+          if (sym->kind == SymbolKind.PARENTHESIS)
             break;
           else
           {
-            if (sym.kind == SymbolKind.FUNCTION)
-              pushfunction (sym.token, 1);
+            if (sym->kind == SymbolKind.FUNCTION)
+              pushfunction (sym->token, 1);
             else
-            if (sym.kind == SymbolKind.OPERATOR)
+            if (sym->kind == SymbolKind.OPERATOR)
             {
-              unowned var oclass = sym.klass.opclass;
+              unowned var oclass = sym->klass.opclass;
               unowned var n_args = (oclass.unary) ? 1 : 2;
-              pushfunction (sym.token, n_args);
+              pushfunction (sym->token, n_args);
             }
 
             popsym ();
@@ -193,28 +196,28 @@ namespace Abaco
       case SymbolKind.OPERATOR:
         while (true)
         {
-          unowned var sym = peeksym ();
+          var sym = peeksym ();
           if (sym == null)
             break;
           else
-          if (sym.kind == SymbolKind.OPERATOR)
+          if (sym->kind == SymbolKind.OPERATOR)
           {
             unowned OperatorClass oclass1 = klass.opclass;
-            unowned OperatorClass oclass2 = sym.klass.opclass;
+            unowned OperatorClass oclass2 = sym->klass.opclass;
             if (oclass2.precedence > oclass1.precedence
               || (oclass2.precedence == oclass1.precedence
               && (oclass1.assoc == OperatorAssoc.LEFT)))
             {
               var n_args = (oclass2.unary) ? 1 : 2;
-              pushfunction (sym.token, n_args);
+              pushfunction (sym->token, n_args);
               popsym ();
               continue;
             }
           }
           else
-          if (sym.kind == SymbolKind.FUNCTION)
+          if (sym->kind == SymbolKind.FUNCTION)
           {
-            pushfunction (sym.token, 1);
+            pushfunction (sym->token, 1);
             popsym ();
             continue;
           }
@@ -240,16 +243,16 @@ namespace Abaco
           flushpar (token);
           popsym ();
 
-          unowned var sym = peeksym ();
+          var sym = peeksym ();
           if (sym != null &&
-            sym.kind == SymbolKind.FUNCTION)
+            sym->kind == SymbolKind.FUNCTION)
           {
             var n_args = args.pop_head ();
             if (pklass.kind == SymbolKind.PARENTHESIS
               && ptoken [0] == '(')
-              pushfunction (sym.token, 0);
+              pushfunction (sym->token, 0);
             else
-              pushfunction (sym.token, n_args);
+              pushfunction (sym->token, n_args);
             popsym ();
           }
         }
@@ -262,23 +265,23 @@ namespace Abaco
 
     public Ast.Node finish () throws GLib.Error
     {
-      unowned Symbol sym;
+      Symbol* sym;
       while ((sym = peeksym ()) != null)
       {
-        if (sym.kind == SymbolKind.PARENTHESIS)
+        if (sym->kind == SymbolKind.PARENTHESIS)
         {
           var msg = ("unmatched '(' parenthesis");
           throw new ExpressionError.UNMATCHED_PARENTHESIS (msg);
         }
 
-        if (sym.kind == SymbolKind.FUNCTION)
-          pushfunction (sym.token, 1);
+        if (sym->kind == SymbolKind.FUNCTION)
+          pushfunction (sym->token, 1);
         else
-        if (sym.kind == SymbolKind.OPERATOR)
+        if (sym->kind == SymbolKind.OPERATOR)
         {
-          unowned var oclass = sym.klass.opclass;
+          unowned var oclass = sym->klass.opclass;
           var n_args = (oclass.unary) ? 1 : 2;
-          pushfunction (sym.token, n_args);
+          pushfunction (sym->token, n_args);
         }
 
         popsym ();
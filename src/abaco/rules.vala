@@ -32,10 +32,18 @@ namespace Abaco
 
   public sealed class Rules : GLib.Object
   {
+    const uint MAX_MEMOIZED = 1024;
+    const char LITERAL = '\x01';
+    const char SEPARATOR = '\x02';
     private GenericArray<GLib.Regex> tokexp;
     private Array<ClassEntry> clsexp;
     private int fn_token = -1;
     private int fn_class = -1;
+    private Lexer? lexer = null;
+    private bool lexer_stale = true;
+    private HashTable<string, int> clsmemo;
+    private uint _generation = 0;
+    private bool _code_strict = false;
 
   #if DEVELOPER == 1
     public Assembler placeholder1 { get; set; }
@@ -46,7 +54,20 @@ namespace Abaco
    *
    */
 
-    public bool code_strict { get; set; }
+    public bool code_strict
+    {
+      get { return _code_strict; }
+      set { _code_strict = value; ++_generation; }
+    }
+
+    /*
+     * Bumped on every token, class or strictness
+     * change, so code compiled against an older rule
+     * set can be told apart (see Cache).
+     *
+     */
+
+    public uint generation { get { return _generation; } }
 
   /*
    * types
@@ -78,6 +99,8 @@ namespace Abaco
       var regex = new GLib.Regex (expr, flags);
       var at = (pos == -1) ? tokexp.length : pos;
       tokexp.insert (at, regex);
+      lexer_stale = true;
+      ++_generation;
     }
 
     private void add_class (string expr, int pos, ref SymbolClass klass) throws GLib.Error
@@ -89,13 +112,28 @@ namespace Abaco
       clsexp.insert_val (at, new ClassEntry ());
       clsexp.index (at).regex = regex;
       clsexp.index (at).klass = klass;
+      clsmemo.remove_all ();
+      lexer_stale = true;
+      ++_generation;
     }
 
     private bool _validate_len (string? input, ref ssize_t length)
       requires (input != null)
     {
+      unowned var bytes = (uint8*) input;
       char* end = null;
       bool valid = false;
+      ssize_t i;
+
+      /* plain ASCII needs no decoding */
+      for (i = 0; (length < 0) ? bytes [i] != 0 : i < length; i++)
+        if (bytes [i] >= 0x80)
+          break;
+      if ((length < 0) ? bytes [i] == 0 : i == length)
+      {
+        length = i;
+        return true;
+      }
 
       valid = input.validate (length, out end);
       length = (ssize_t) (end - (char*) input);
@@ -173,18 +211,74 @@ namespace Abaco
     return tokens;
     }
 
-    private unowned SymbolClass* classify (string? input, ssize_t length) throws GLib.Error
-      requires (_validate_len (input, ref length))
+    private unowned Lexer? get_lexer ()
+    {
+      /*
+       * Token and class rules compile into a lexer which
+       * splits and classifies in a single pass, rebuilt on
+       * first use after the rules change; rules it can't
+       * express leave the regex path in charge. Priority
+       * is kept per position (the first rule matching
+       * there wins, with its longest match) instead of
+       * splitting around the first rule matching anywhere,
+       * which tokenizes the same unless a later rule's
+       * match straddles an earlier rule's one
+       *
+       */
+
+      if (lexer_stale)
+      {
+        lexer_stale = false;
+        lexer = new Lexer ();
+
+        for (int i = 0; i < tokexp.length; i++)
+        if (!lexer.add_token (tokexp [i].get_pattern ()))
+        {
+          lexer = null;
+          return null;
+        }
+
+        for (uint i = 0; i < clsexp.length; i++)
+        if (!lexer.add_class (clsexp.index (i).regex.get_pattern ()))
+        {
+          lexer = null;
+          return null;
+        }
+      }
+    return lexer;
+    }
+
+    private unowned SymbolClass* classify (string token) throws GLib.Error
     {
-      var clsexps = clsexp.length;
-      for (int i = 0; i < clsexps; i++)
+      /*
+       * Tokens are slices of input validated once by
+       * parse, and expressions keep reusing the same few
+       * names, so classes are memoized by token text (as
+       * index + 1) until the class rules change
+       *
+       */
+
+      var index = clsmemo.lookup (token) - 1;
+      if (index < 0)
       {
-        unowned ClassEntry klass = clsexp.index (i);
-        unowned GLib.Regex regex = klass.regex;
-        if (regex.match_full (input, length, 0, 0, null))
-          return & klass.klass;
+        var clsexps = clsexp.length;
+        for (int i = 0; i < clsexps; i++)
+        {
+          unowned GLib.Regex regex = clsexp.index (i).regex;
+          if (regex.match_full (token, -1, 0, 0, null))
+          {
+            index = i;
+            break;
+          }
+        }
+
+        if (index < 0)
+          return null;
+        if (clsmemo.size () >= MAX_MEMOIZED)
+          clsmemo.remove_all ();
+        clsmemo.insert (token, index + 1);
       }
-    return null;
+    return & clsexp.index (index).klass;
     }
 
   /*
@@ -221,6 +315,36 @@ namespace Abaco
       add_class (expr, fn_class, ref klass);
     }
 
+    private bool normalize_token (GLib.StringBuilder key, char* token, size_t size, SymbolKind kind, GLib.HashTable<string, int> slots, ref string[] literals)
+    {
+      if (kind == SymbolKind.UNKNOWN && !code_strict)
+        return true;
+      if (kind != SymbolKind.CONSTANT)
+      {
+        for (size_t i = 0; i < size; i++)
+        if (token [i] == LITERAL || token [i] == SEPARATOR)
+          return false;
+        key.append_len ((string) token, (ssize_t) size);
+      }
+      else
+      {
+        var literal = ((string) token).ndup (size);
+        var slot = slots.lookup (literal);
+        if (slot == 0)
+        {
+          slot = literals.length + 1;
+          slots.insert (literal, slot);
+          literals += (owned) literal;
+        }
+
+        key.append_c (LITERAL);
+        key.append_printf ("%i", slot - 1);
+      }
+
+      key.append_c (SEPARATOR);
+    return true;
+    }
+
     private ssize_t calculate_offset (string[] tokens, uint til)
     {
       ssize_t offset = 0;
@@ -237,10 +361,122 @@ namespace Abaco
     return offset;
     }
 
+    private Ast.Node parse_lexer (Lexer automaton, string input, ssize_t length) throws GLib.Error
+    {
+      var chunk = new GLib.StringChunk (128);
+      var parser = new Parser ();
+      unowned var klass = (SymbolClass*) null;
+      unowned var token = (string) null;
+      char* ptr = (char*) input;
+      char* top = ptr + length;
+      size_t size;
+      int index;
+
+      parser.code_strict = code_strict;
+
+      while ((size = automaton.next (ptr, (size_t) (top - ptr), out index)) > 0)
+      {
+        token = chunk.insert_len ((string) ptr, (ssize_t) size);
+        if (index < 0)
+        {
+          var offset = input.char_count ((ssize_t) (ptr - (char*) input));
+          var msg = ("%li: unclassed token '%s'").printf (offset, token);
+          throw new ExpressionError.FAILED (msg);
+        }
+        else
+        {
+          klass = & clsexp.index (index).klass;
+
+          try
+          {
+            parser.consume (token, *klass);
+          } catch (ExpressionError e)
+          {
+            var emit = (GLib.Error) null;
+            Error.propagate_prefixed
+            (out emit, e, "%li: ",
+              input.char_count ((ssize_t) (ptr - (char*) input)));
+            throw emit;
+          }
+        }
+
+        ptr += size;
+      }
+    return parser.finish ();
+    }
+
+    /*
+     * Literal-free form of an expression: constants
+     * become placeholders naming their slot in 'literals'
+     * (distinct values, in order of appearance), so
+     * expressions which only differ in numbers share a
+     * key. Returns null if input can't be normalized.
+     *
+     */
+
+    public string? normalize (string? input, ssize_t length, out string[] literals)
+    {
+      var slots = new GLib.HashTable<string, int> (GLib.str_hash, GLib.str_equal);
+      string[] values = {};
+      literals = null;
+
+      if (!_validate_len (input, ref length))
+        return null;
+
+      var key = new GLib.StringBuilder.sized ((size_t) length + 16);
+      unowned var automaton = get_lexer ();
+      if (automaton != null)
+      {
+        char* ptr = (char*) input;
+        char* top = ptr + length;
+        size_t size;
+        int index;
+
+        while ((size = automaton.next (ptr, (size_t) (top - ptr), out index)) > 0)
+        {
+          if (index < 0)
+            return null;
+          var kind = clsexp.index (index).klass.kind;
+          if (!normalize_token (key, ptr, size, kind, slots, ref values))
+            return null;
+          ptr += size;
+        }
+      }
+      else
+      {
+        try
+        {
+          var tokens_ = tokenize (input, length);
+          unowned var tokens = tokens_.array.data;
+          unowned var token = (string) null;
+          unowned var t = (int) (-1);
+
+          while ((token = tokens [++t]) != null)
+          {
+            unowned var klass = classify (token);
+            if (klass == null
+              || !normalize_token (key, (char*) token, token.length, klass->kind, slots, ref values))
+              return null;
+          }
+        }
+        catch (GLib.Error e)
+        {
+          return null;
+        }
+      }
+
+      literals = (owned) values;
+    return (owned) key.str;
+    }
+
     public Ast.Node parse (string? input, ssize_t length = -1) throws GLib.Error
     {
       if (!_validate_len (input, ref length))
         throw new ExpressionError.NOT_UTF8 ("");
+      unowned var automaton = get_lexer ();
+      if (automaton != null)
+        return parse_lexer (automaton, input, length);
+
       var tokens_ = tokenize (input, length);
       var parser = new Parser ();
       unowned var tokens = tokens_.array.data;
@@ -252,7 +488,7 @@ namespace Abaco
 
       while ((token = tokens [++t]) != null)
       {
-        klass = classify (token, -1);
+        klass = classify (token);
         if (klass == null)
         {
           var offset = calculate_offset (tokens, t);
@@ -286,6 +522,7 @@ namespace Abaco
     {
       tokexp = new GenericArray<GLib.Regex> ();
       clsexp = new Array<ClassEntry> ();
+      clsmemo = new HashTable<string, int> (GLib.str_hash, GLib.str_equal);
       SymbolClass klass;
 
       try
@@ -24,6 +24,8 @@ namespace Abaco
     private Abaco.Assembler assembler;
     private Abaco.Rules rules;
 
+    public Abaco.Cache cache { get; private set; }
+
     /* type API */
 
     public abstract class State
@@ -335,6 +337,19 @@ namespace Abaco
 
     protected abstract State new_state (GLib.Bytes code);
 
+    /*
+     * Whatever compiled closures capture from the
+     * calling thread (precision, rounding and so)
+     * so cached closures are only reused under
+     * the same evaluation context
+     *
+     */
+
+    protected virtual GLib.Bytes? context_key ()
+    {
+      return null;
+    }
+
     /* protected API */
 
     protected unowned Relation? get_relation (string expr)
@@ -350,12 +365,83 @@ namespace Abaco
 
     /* public API */
 
-    public Closure? compile_bytes (GLib.Bytes code) throws GLib.Error
+    public bool fuse
+    {
+      get { return assembler.fuse; }
+      set { assembler.fuse = value; }
+    }
+
+    public bool parameterize
+    {
+      get { return assembler.parameterize; }
+      set { assembler.parameterize = value; }
+    }
+
+    private GLib.Bytes assemble (GLib.Bytes code, uint generation) throws GLib.Error
     {
       unowned var expr = code.get_data ();
-      var tree = rules.parse ((string) expr, expr.length);
-      var byte = assembler.assemble (tree);
-    return compile (byte);
+      var literals = (string[]) null;
+      var key = (string?) null;
+
+      if (!assembler.parameterize
+        || (key = rules.normalize ((string) expr, expr.length, out literals)) == null)
+      {
+        var tree = rules.parse ((string) expr, expr.length);
+        return assembler.assemble (tree);
+      }
+
+      /*
+       * Closures embed their literals, so only the
+       * template is shared between expressions which
+       * differ in numbers
+       *
+       */
+
+      var source = new GLib.Bytes (key.data);
+      var template = cache.lookup (source, generation);
+      if (template == null)
+      {
+        var tree = rules.parse ((string) expr, expr.length);
+        template = assembler.assemble_template (tree, literals);
+        cache.insert (source, generation, template);
+      }
+    return Abaco.Assembler.bind (template, literals);
+    }
+
+    private GLib.Bytes closure_key (GLib.Bytes code)
+    {
+      var context = context_key ();
+      if (context == null)
+        return code;
+
+      /*
+       * Context keys have a fixed size per
+       * implementation, so appending it after
+       * the source keeps keys unambiguous
+       *
+       */
+
+      var array = new GLib.ByteArray.sized ((uint) (code.get_size () + context.get_size ()));
+        array.append (code.get_data ());
+        array.append (context.get_data ());
+    return GLib.ByteArray.free_to_bytes ((owned) array);
+    }
+
+    public Closure? compile_bytes (GLib.Bytes code) throws GLib.Error
+    {
+      var generation = rules.generation << 2
+                     | (assembler.parameterize ? 2 : 0)
+                     | (assembler.fuse ? 1 : 0);
+      var source = closure_key (code);
+      var closure = cache.lookup_closure (source, generation);
+      if (closure != null)
+        return closure;
+
+      var byte = assemble (code, generation);
+
+      if ((closure = compile (byte)) != null)
+        cache.insert (source, generation, byte, closure);
+    return closure;
     }
 
     public Closure? compile_string (string code) throws GLib.Error
@@ -402,6 +488,7 @@ namespace Abaco
       this.relations = new HashTable<Relation, bool> (hash, equal);
       this.assembler = new Abaco.Assembler ();
       this.rules = new Abaco.Rules ();
+      this.cache = new Abaco.Cache ();
     }
 
     public new static Jit @new (GLib.Type type)
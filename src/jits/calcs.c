@@ -19,13 +19,13 @@
 #include <libabaco_jits.h>
 #include <x86_64/state.h>
 
-#define accum(suffix,invert) \
+#define accum(suffix,invert,wrap_n) \
   gpointer \
   abaco_jits_##suffix (AbacoJitState* state, const gchar* expr) \
   { \
     gpointer lpc = NULL; \
     if (G_TYPE_CHECK_INSTANCE_TYPE (state, ABACO_JITS_TYPE_X86_64_STATE)) \
-      lpc = abaco_jits_x86_64_accum_wrap (state, expr, (invert), ucl_##suffix ); \
+      lpc = abaco_jits_x86_64_accum_wrap (state, expr, (invert), ucl_##suffix, (wrap_n)); \
     else \
     { \
       /* TODO: add generic interface */ \
@@ -35,10 +35,36 @@
   return lpc; \
   }
 
-accum (arithmetic_add, FALSE)
-accum (arithmetic_sub, FALSE)
-accum (arithmetic_mul, FALSE)
-accum (arithmetic_div, FALSE)
+accum (arithmetic_add, FALSE, ucl_arithmetic_add_n)
+accum (arithmetic_sub, FALSE, ucl_arithmetic_sub_n)
+accum (arithmetic_mul, FALSE, ucl_arithmetic_mul_n)
+accum (arithmetic_div, FALSE, ucl_arithmetic_div_n)
+
+static void
+_jits_fma_n (UclReg* accum, const UclReg* nexts, guint n_nexts)
+{
+  if (G_UNLIKELY (n_nexts != 3))
+    g_error ("Bad arguments (3 expected, got %u)", n_nexts);
+
+  /* fma (a, b, c) = a * b + c, accumulated on c */
+  ucl_reg_copy (accum, & nexts [2]);
+  ucl_arithmetic_fma (accum, & nexts [0], & nexts [1]);
+}
+
+gpointer
+abaco_jits_arithmetic_fma (AbacoJitState* state, const gchar* expr)
+{
+  gpointer lpc = NULL;
+  if (G_TYPE_CHECK_INSTANCE_TYPE (state, ABACO_JITS_TYPE_X86_64_STATE))
+    lpc = abaco_jits_x86_64_accum_wrap (state, expr, FALSE, NULL, _jits_fma_n);
+  else
+  {
+    /* TODO: add generic interface */
+    g_error ("Unknown state architecture");
+    g_assert_not_reached ();
+  }
+return lpc;
+}
 
 void
 abaco_jits_arithmetic (AbacoJit* jit)
@@ -60,9 +86,40 @@ abaco_jits_arithmetic (AbacoJit* jit)
   relation = abaco_jit_relation_new (abaco_jits_arithmetic_div);
              abaco_jit_relation_set_name (relation, "/");
   abaco_jit_add_operator (jit, relation, FALSE, 3, FALSE);
+
+  relation = abaco_jit_relation_new (abaco_jits_arithmetic_fma);
+             abaco_jit_relation_set_name (relation, "fma");
+  abaco_jit_add_function (jit, relation, 3);
+  abaco_jit_set_fuse (jit, TRUE);
 }
 
-accum (power_pow, TRUE)
+accum (power_pow, TRUE, NULL)
+
+#define root(name) \
+  static void \
+  _jits_##name (UclReg* accum, const UclReg* next) \
+  { \
+    ucl_reg_copy (accum, next); \
+    ucl_power_##name (accum); \
+  } \
+ ; \
+  gpointer \
+  abaco_jits_power_##name (AbacoJitState* state, const gchar* expr) \
+  { \
+    gpointer lpc = NULL; \
+    if (G_TYPE_CHECK_INSTANCE_TYPE (state, ABACO_JITS_TYPE_X86_64_STATE)) \
+      lpc = abaco_jits_x86_64_accum_wrap (state, expr, FALSE, _jits_##name, NULL); \
+    else \
+    { \
+      /* TODO: add generic interface */ \
+      g_error ("Unknown state architecture"); \
+      g_assert_not_reached (); \
+    } \
+  return lpc; \
+  }
+
+root (sqrt)
+root (cbrt)
 
 void
 abaco_jits_power (AbacoJit* jit)
@@ -72,4 +129,12 @@ abaco_jits_power (AbacoJit* jit)
   relation = abaco_jit_relation_new (abaco_jits_power_pow);
              abaco_jit_relation_set_name (relation, "^");
   abaco_jit_add_operator (jit, relation, TRUE, 4, FALSE);
+
+  relation = abaco_jit_relation_new (abaco_jits_power_sqrt);
+             abaco_jit_relation_set_name (relation, "sqrt");
+  abaco_jit_add_function (jit, relation, 1);
+
+  relation = abaco_jit_relation_new (abaco_jits_power_cbrt);
+             abaco_jit_relation_set_name (relation, "cbrt");
+  abaco_jit_add_function (jit, relation, 1);
 }
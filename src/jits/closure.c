@@ -57,6 +57,7 @@ _closure_marshal (GClosure* closure,
 
   gpointer callback = NULL;
   UclReg stat [1024 / regsz];
+  const UclContext* last = NULL;
   UclReg* stack = NULL;
   guint i;
 
@@ -75,6 +76,8 @@ _closure_marshal (GClosure* closure,
 #endif // HAVE_MEMSET
   }
 
+  last = ucl_context_enter (& cc->context);
+
   for (i = 0; i < n_params; i++)
     ucl_reg_load (& stack [i], & params [i]);
 
@@ -113,12 +116,33 @@ _closure_marshal (GClosure* closure,
 # error "Unimplemented architecture"
 #endif // __x86_64__
 
-  g_value_take_string (result, ucl_reg_save_string (stack, cc->base));
+  /* numeric results skip formatting altogether */
+  if (G_VALUE_HOLDS_DOUBLE (result))
+    g_value_set_double (result, ucl_reg_save_double (stack));
+  else
+    g_value_take_string (result, ucl_reg_save_string (stack, cc->base));
   ucl_reg_unsets (stack, cc->stacksz);
+  ucl_context_leave (last);
   if (stack != & stat[0])
     g_free (stack);
 }
 
+static void
+_closure_capture (UclContext* context)
+{
+  context->precision = ucl_context_get_precision ();
+  context->rounding = ucl_context_get_rounding ();
+  context->fast = ucl_context_get_fast ();
+}
+
+GBytes*
+abaco_jits_closure_context (void)
+{
+  UclContext context = {0};
+  _closure_capture (&context);
+return g_bytes_new (&context, sizeof (context));
+}
+
 Closure*
 abaco_jits_closure_new (gsize blocksz)
 {
@@ -133,6 +157,7 @@ abaco_jits_closure_new (gsize blocksz)
   g_closure_set_marshal (gc, _closure_marshal);
 
   cc->blocksz = blocksz;
+  _closure_capture (&cc->context);
 #ifdef G_OS_WINDOWS
   cc->block = VirtualAlloc (0, blocksz, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
 #else // !G_OS_WINDOWS
@@ -18,6 +18,7 @@
 #ifndef __JITS_CLOSURE__
 #define __JITS_CLOSURE__ 1
 #include <glib-object.h>
+#include <libabaco_ucl.h>
 
 #define EXPORT G_GNUC_INTERNAL
 typedef struct _Closure Closure;
@@ -33,6 +34,7 @@ struct _Closure
   gpointer block;
   gsize blocksz;
   gsize stacksz;
+  UclContext context;
   int base;
 };
 
@@ -42,6 +44,8 @@ EXPORT Closure*
 abaco_jits_closure_new (gsize blocksz);
 EXPORT void
 abaco_jits_closure_prepare (Closure* cc);
+EXPORT GBytes*
+abaco_jits_closure_context (void);
 
 #if __cplusplus
 }
@@ -46,14 +46,16 @@ JITS_EXPORT gpointer
 abaco_jits_arithmetic_mul (AbacoJitState* state, const gchar* expr);
 JITS_EXPORT gpointer
 abaco_jits_arithmetic_div (AbacoJitState* state, const gchar* expr);
+JITS_EXPORT gpointer
+abaco_jits_arithmetic_fma (AbacoJitState* state, const gchar* expr);
 JITS_EXPORT void
 abaco_jits_power (AbacoJit* jit);
 JITS_EXPORT gpointer
-abaco_jits_arithmetic_sqrt (AbacoJitState* state, const gchar* expr);
+abaco_jits_power_pow (AbacoJitState* state, const gchar* expr);
 JITS_EXPORT gpointer
-abaco_jits_arithmetic_cbrt (AbacoJitState* state, const gchar* expr);
+abaco_jits_power_sqrt (AbacoJitState* state, const gchar* expr);
 JITS_EXPORT gpointer
-abaco_jits_arithmetic_pow (AbacoJitState* state, const gchar* expr);
+abaco_jits_power_cbrt (AbacoJitState* state, const gchar* expr);
 
 #if __cplusplus
 }
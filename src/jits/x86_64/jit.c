@@ -16,6 +16,7 @@
  *
  */
 #include <config.h>
+#include <./closure.h>
 #include <x86_64/jit.h>
 #include <x86_64/state.h>
 
@@ -46,11 +47,18 @@ abaco_jits_x86_64_class_new_state (AbacoJit* self, GBytes* code)
   return abaco_jits_x86_64_state_new (self, code);
 }
 
+static GBytes*
+abaco_jits_x86_64_class_context_key (AbacoJit* self)
+{
+  return abaco_jits_closure_context ();
+}
+
 static void
 abaco_jits_x86_64_class_init (AbacoJitsX8664Class* klass)
 {
   AbacoJitClass* jclass = ABACO_JIT_CLASS (klass);
   jclass->new_state = abaco_jits_x86_64_class_new_state;
+  jclass->context_key = abaco_jits_x86_64_class_context_key;
 }
 
 static void
@@ -508,11 +508,51 @@ abaco_jits_x86_64_state_getpc (gpointer pself, guint* out_pc, const gchar* key)
 }
 
 gpointer
-abaco_jits_x86_64_accum_wrap (gpointer pself, const gchar* name, gboolean invert, AccumWrap wrap)
+abaco_jits_x86_64_accum_wrap (gpointer pself, const gchar* name, gboolean invert, AccumWrap wrap, AccumWrapN wrap_n)
 {
   AbacoJitsX8664State* self = pself;
   guint pc = 0;
 
+  if (wrap_n != NULL && !invert)
+  {
+    if (!abaco_jits_x86_64_state_getpc (self, &pc, name))
+    {
+      /* forward folds hand the whole operand window over */
+      const gsize space = sizeof (gpointer) * 4;
+      const guintptr func = GUINT64_TO_LE ((guintptr) wrap_n);
+#if __DASC__
+      |.symbols
+      |=>(pc):
+      | sub rsp, (space)
+      | mov Addr:rsp [0], r12
+      | mov Addr:rsp [1], r13
+      | mov Addr:rsp [2], r14
+      | mov Addr:rsp [3], rbx
+      | mov rbx, qword [>1]
+      | slot_d arg1, arg1
+      | mov r12, arg1
+      | slot_d r13, arg2
+      | mov r14, arg3
+      | call extern _jit_clean
+      | mov arg1, r12
+      | mov arg2, r13
+      | mov arg3, r14
+      | call rbx
+      | mov r12, Addr:rsp [0]
+      | mov r13, Addr:rsp [1]
+      | mov r14, Addr:rsp [2]
+      | mov rbx, Addr:rsp [3]
+      | add rsp, (space)
+      | ret
+      |1:
+      |.dword (func & G_MAXUINT32)
+      |.dword (func >> 32)
+      |.code
+#endif // __DASC__
+    }
+    return GUINT_TO_POINTER (pc);
+  }
+
   if (!abaco_jits_x86_64_state_getpc (self, &pc, name))
   {
     const gsize space = sizeof (gpointer) * 4;
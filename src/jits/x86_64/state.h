@@ -27,6 +27,7 @@ extern "C" {
 #endif // __cplusplus
 
 typedef void (*AccumWrap) (UclReg* accum, const UclReg* next);
+typedef void (*AccumWrapN) (UclReg* accum, const UclReg* nexts, guint n_nexts);
 
 /*
  * internal API
@@ -40,7 +41,7 @@ abaco_jits_x86_64_state_new (AbacoJit* back, GBytes* code);
 G_GNUC_INTERNAL gboolean
 abaco_jits_x86_64_state_getpc (gpointer pself, guint* out_pc, const gchar* key);
 G_GNUC_INTERNAL gpointer
-abaco_jits_x86_64_accum_wrap (gpointer pself, const gchar* name, gboolean invert, AccumWrap wrap);
+abaco_jits_x86_64_accum_wrap (gpointer pself, const gchar* name, gboolean invert, AccumWrap wrap, AccumWrapN wrap_n);
 
 #if __cplusplus
 }
@@ -0,0 +1,407 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <arena.h>
+#include <gmp.h>
+#include <mpfr.h>
+#include <string.h>
+
+#define ARENA_ALIGN (sizeof (gpointer) * 2)
+#define CHUNK_SIZE (1 << 14)
+
+#if MPFR_VERSION >= MPFR_VERSION_NUM(4,0,0)
+# define _mpfr_cleanup() (mpfr_mp_memory_cleanup ())
+#else // MPFR_VERSION < 4.0.0
+# define _mpfr_cleanup() (mpfr_free_cache ())
+#endif // MPFR_VERSION
+
+typedef struct _MpChunk MpChunk;
+
+struct _MpChunk
+{
+  MpChunk* next;
+  gsize size;
+  gsize used;
+  guint8 data [] __attribute__ ((aligned (ARENA_ALIGN)));
+};
+
+struct _MpArena
+{
+  MpChunk* chunks;
+  GPtrArray* ranges;
+  const guint8* lo;
+  const guint8* hi;
+  gsize total;
+  gsize used;
+  gsize peak;
+  gboolean bump;
+};
+
+/*
+ * GMP memory functions are process wide, so hooks
+ * are installed once and route to the arena current
+ * on the calling thread; blocks the arena does not
+ * own go to whatever functions were there before.
+ * Arena blocks are only released in bulk, when the
+ * scope which opened the arena leaves
+ *
+ */
+
+static __thread MpArena* _mp_arena_current = NULL;
+static void* (*_mp_prev_alloc) (size_t) = NULL;
+static void* (*_mp_prev_realloc) (void*, size_t, size_t) = NULL;
+static void (*_mp_prev_free) (void*, size_t) = NULL;
+
+static inline gsize
+_mp_arena_align (gsize size)
+{
+  return (size + (ARENA_ALIGN - 1)) & ~ (gsize) (ARENA_ALIGN - 1);
+}
+
+static inline gsize
+_mp_arena_round (gsize size)
+{
+  return (size + (CHUNK_SIZE - 1)) & ~ (gsize) (CHUNK_SIZE - 1);
+}
+
+static inline gboolean
+_mp_chunk_has (MpChunk* chunk, const guint8* ptr)
+{
+  return ptr >= chunk->data && ptr < chunk->data + chunk->size;
+}
+
+static void
+_mp_arena_add (MpArena* arena, gsize size)
+{
+  MpChunk* chunk = g_malloc (sizeof (MpChunk) + size);
+  guint lo = 0, hi = arena->ranges->len, mid;
+
+  chunk->next = arena->chunks;
+  chunk->size = size;
+  chunk->used = 0;
+
+  /* ranges stay sorted by address for _mp_arena_owns */
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (((MpChunk*) g_ptr_array_index (arena->ranges, mid))->data < chunk->data)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  g_ptr_array_insert (arena->ranges, lo, chunk);
+  if (arena->lo == NULL || arena->lo > chunk->data)
+    arena->lo = chunk->data;
+  if (arena->hi == NULL || arena->hi < chunk->data + size)
+    arena->hi = chunk->data + size;
+
+  arena->chunks = chunk;
+  arena->total += size;
+}
+
+static inline gboolean
+_mp_arena_owns (MpArena* arena, gconstpointer ptr)
+{
+  const guint8* p = ptr;
+  MpChunk* chunk = arena->chunks;
+  guint lo = 0, hi, mid;
+
+  /* most blocks come from the latest chunk */
+  if (chunk == NULL || _mp_chunk_has (chunk, p))
+    return chunk != NULL;
+  if (p < arena->lo || p >= arena->hi)
+    return FALSE;
+
+  for (hi = arena->ranges->len; lo < hi;)
+  {
+    mid = lo + (hi - lo) / 2;
+    chunk = g_ptr_array_index (arena->ranges, mid);
+
+    if (p < chunk->data)
+      hi = mid;
+    else
+    if (p >= chunk->data + chunk->size)
+      lo = mid + 1;
+    else
+      return TRUE;
+  }
+return FALSE;
+}
+
+static inline gboolean
+_mp_arena_is_last (MpArena* arena, gconstpointer ptr, gsize size)
+{
+  MpChunk* chunk = arena->chunks;
+return (const guint8*) ptr + size == chunk->data + chunk->used;
+}
+
+static inline void
+_mp_arena_account (MpArena* arena, gsize old, gsize new)
+{
+  arena->used = arena->used - old + new;
+  arena->peak = MAX (arena->peak, arena->used);
+}
+
+static gpointer
+_mp_arena_bump (MpArena* arena, gsize size)
+{
+  MpChunk* chunk = arena->chunks;
+  gpointer ptr = NULL;
+
+  size = _mp_arena_align (size);
+  if (chunk == NULL || chunk->size - chunk->used < size)
+  {
+    gsize want = MAX (CHUNK_SIZE, size);
+    if (chunk != NULL)
+      want = MAX (want, chunk->size * 2);
+
+    _mp_arena_add (arena, want);
+    chunk = arena->chunks;
+  }
+
+  ptr = chunk->data + chunk->used;
+  chunk->used += size;
+  _mp_arena_account (arena, 0, size);
+return ptr;
+}
+
+static void
+_mp_arena_drop (MpArena* arena)
+{
+  MpChunk* chunk = NULL;
+  MpChunk* next = NULL;
+
+  for (chunk = arena->chunks; chunk != NULL; chunk = next)
+  {
+    next = chunk->next;
+    g_free (chunk);
+  }
+
+  g_ptr_array_set_size (arena->ranges, 0);
+  arena->chunks = NULL;
+  arena->lo = NULL;
+  arena->hi = NULL;
+  arena->total = 0;
+}
+
+static void
+_mp_arena_reset (MpArena* arena)
+{
+  MpChunk* chunk = arena->chunks;
+  gsize want = _mp_arena_round (MAX (arena->peak, CHUNK_SIZE));
+
+  /*
+   * Keep one chunk sized for the scope just left:
+   * several chunks coalesce, so a scope like it
+   * fits without growing, and a chunk far larger
+   * than needed (after a one-off spike) shrinks
+   *
+   */
+
+  arena->used = 0;
+  arena->peak = 0;
+
+  if (chunk == NULL)
+    return;
+  if (chunk->next == NULL
+    && chunk->size >= want
+    && chunk->size / 4 <= want)
+    chunk->used = 0;
+  else
+  {
+    _mp_arena_drop (arena);
+    _mp_arena_add (arena, want);
+  }
+}
+
+static void*
+_mp_arena_alloc_hook (size_t size)
+{
+  MpArena* arena = _mp_arena_current;
+  if (arena != NULL && arena->bump)
+    return _mp_arena_bump (arena, size);
+return _mp_prev_alloc (size);
+}
+
+static void*
+_mp_arena_realloc_hook (void* ptr, size_t old_size, size_t new_size)
+{
+  MpArena* arena = _mp_arena_current;
+  if (arena == NULL || !_mp_arena_owns (arena, ptr))
+    return _mp_prev_realloc (ptr, old_size, new_size);
+  else
+  {
+    MpChunk* chunk = arena->chunks;
+    gsize old = _mp_arena_align (old_size);
+    gsize new = _mp_arena_align (new_size);
+    gpointer next = NULL;
+
+    /* the latest block resizes in place */
+    if (arena->bump
+      && _mp_arena_is_last (arena, ptr, old)
+      && chunk->size - (chunk->used - old) >= new)
+    {
+      chunk->used = chunk->used - old + new;
+      _mp_arena_account (arena, old, new);
+      return ptr;
+    }
+
+    if (new <= old)
+      return ptr;
+    if (arena->bump)
+      next = _mp_arena_bump (arena, new_size);
+    else
+      next = _mp_prev_alloc (new_size);
+
+    memcpy (next, ptr, old_size);
+  return next;
+  }
+}
+
+static void
+_mp_arena_free_hook (void* ptr, size_t size)
+{
+  MpArena* arena = _mp_arena_current;
+  if (arena == NULL || !_mp_arena_owns (arena, ptr))
+    _mp_prev_free (ptr, size);
+  else
+  {
+    /* the latest block rewinds, the rest waits for the reset */
+    gsize old = _mp_arena_align (size);
+    if (_mp_arena_is_last (arena, ptr, old))
+    {
+      arena->chunks->used -= old;
+      arena->used -= old;
+    }
+  }
+}
+
+static void
+_mp_arena_install (void)
+{
+  static gsize once = 0;
+  if (g_once_init_enter (&once))
+  {
+    /* MPFR caches must not outlive the functions they came from */
+    _mpfr_cleanup ();
+    mp_get_memory_functions (&_mp_prev_alloc, &_mp_prev_realloc, &_mp_prev_free);
+    mp_set_memory_functions (_mp_arena_alloc_hook, _mp_arena_realloc_hook, _mp_arena_free_hook);
+    g_once_init_leave (&once, 1);
+  }
+}
+
+/* internal API */
+
+MpArena*
+_mp_arena_new (void)
+{
+  MpArena* arena = g_new0 (MpArena, 1);
+  arena->ranges = g_ptr_array_new ();
+  _mp_arena_install ();
+return arena;
+}
+
+void
+_mp_arena_free (MpArena* arena)
+{
+  g_return_if_fail (arena != NULL);
+  g_return_if_fail (arena != _mp_arena_current);
+  _mp_arena_drop (arena);
+  g_ptr_array_unref (arena->ranges);
+  g_free (arena);
+}
+
+MpArenaScope
+_mp_arena_enter (MpArena* arena)
+{
+  MpArena* current = _mp_arena_current;
+
+  /*
+   * Only the outermost scope owns the arena; a nested
+   * scope for another arena (or for no arena at all)
+   * pauses the current one instead, so its values land
+   * on the heap and survive the outer reset
+   *
+   */
+
+  if (current == NULL)
+  {
+    if (arena == NULL)
+      return MP_ARENA_SCOPE_NONE;
+
+    _mp_arena_current = arena;
+    arena->bump = TRUE;
+    return MP_ARENA_SCOPE_OPENED;
+  }
+  else
+  if (current != arena && current->bump)
+  {
+    current->bump = FALSE;
+    return MP_ARENA_SCOPE_SUSPENDED;
+  }
+return MP_ARENA_SCOPE_NONE;
+}
+
+void
+_mp_arena_seal (void)
+{
+  MpArena* current = _mp_arena_current;
+  if (current != NULL)
+    current->bump = FALSE;
+}
+
+gboolean
+_mp_arena_active (void)
+{
+  return _mp_arena_current != NULL;
+}
+
+void
+_mp_arena_leave (MpArenaScope scope)
+{
+  MpArena* current = _mp_arena_current;
+
+  switch (scope)
+  {
+  case MP_ARENA_SCOPE_OPENED:
+    /*
+     * MPFR keeps freed limbs and constants in caches
+     * which would point into reused arena memory, so
+     * they go whenever this scope bumped anything;
+     * scopes which never touched the arena (inline
+     * words, doubles) skip both cleanup and reset
+     *
+     */
+
+    current->bump = FALSE;
+    if (current->peak > 0)
+    {
+      _mpfr_cleanup ();
+      _mp_arena_reset (current);
+    }
+
+    _mp_arena_current = NULL;
+    break;
+  case MP_ARENA_SCOPE_SUSPENDED:
+    current->bump = TRUE;
+    break;
+  default:
+    break;
+  }
+}
@@ -0,0 +1,57 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __MP_ARENA__
+#define __MP_ARENA__ 1
+#ifndef __LIBABACO_MP_INSIDE__
+# error "This is a private header"
+#endif // __LIBABACO_MP_INSIDE__
+#include <glib.h>
+
+#define EXPORT G_GNUC_INTERNAL
+typedef struct _MpArena MpArena;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef enum
+{
+  MP_ARENA_SCOPE_NONE = 0,
+  MP_ARENA_SCOPE_OPENED,      /* caller owns the scope  */
+  MP_ARENA_SCOPE_SUSPENDED,   /* foreign arena paused   */
+} MpArenaScope;
+
+EXPORT MpArena*
+_mp_arena_new (void);
+EXPORT void
+_mp_arena_free (MpArena* arena);
+EXPORT MpArenaScope
+_mp_arena_enter (MpArena* arena);
+EXPORT void
+_mp_arena_seal (void);
+EXPORT gboolean
+_mp_arena_active (void);
+EXPORT void
+_mp_arena_leave (MpArenaScope scope);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#undef EXPORT
+#endif // __MP_ARENA__
@@ -28,26 +28,24 @@ g_error ("Incompatible Virtual Machine"); \
  ; \
   AbacoMP* mp = ABACO_MP (vm); \
   gint i, top = abaco_vm_gettop (vm); \
-  const gchar* type = NULL; \
   UclReg* accum = NULL; \
-  UclReg* next = NULL; \
  ; \
   for (i = 0; i < top; i++) \
   { \
     if (!abaco_mp_isnumber (mp, i)) \
       g_error ("Bad argument #%i (integer, rational or real expected, got %s)", \
         i, abaco_mp_typename (mp, i)); \
+  } \
+ ; \
+  /* arguments are contiguous registers, fold them in one go */ \
+  if (top > 0) \
+  { \
+    accum = _abaco_mp_toreg (mp, 0); \
+    if (top > 1) \
+      ucl_arithmetic_##suffix##_n (accum, _abaco_mp_toreg (mp, 1), top - 1); \
  ; \
-    if (i == 0) \
-    { \
-                        abaco_vm_pushvalue (vm,  0); \
-      accum = (UclReg*) abaco_mp_tointeger (mp, -1); \
-    } \
-    else \
-    { \
-      next = (UclReg*) abaco_mp_tointeger (mp, i); \
-                       ucl_arithmetic_##suffix (accum, next); \
-    } \
+    /* arguments are consumed, accumulate on first one */ \
+    abaco_vm_settop (vm, 1); \
   } \
 return 1; \
 }
@@ -56,3 +54,29 @@ simple (add)
 simple (sub)
 simple (mul)
 simple (div)
+
+int
+abaco_mp_arith_fma (AbacoVM* vm)
+{
+  if (!ABACO_IS_MP (vm))
+g_error ("Incompatible Virtual Machine");
+
+  AbacoMP* mp = ABACO_MP (vm);
+  gint i, top = abaco_vm_gettop (vm);
+
+  if (top != 3)
+    g_error ("Bad arguments (3 expected, got %i)", top);
+
+  for (i = 0; i < top; i++)
+  {
+    if (!abaco_mp_isnumber (mp, i))
+      g_error ("Bad argument #%i (integer, rational or real expected, got %s)",
+        i, abaco_mp_typename (mp, i));
+  }
+
+  /* fma (a, b, c) = a * b + c, accumulated on c */
+  ucl_arithmetic_fma (_abaco_mp_toreg (mp, 2), _abaco_mp_toreg (mp, 0), _abaco_mp_toreg (mp, 1));
+  abaco_vm_exchange (vm, 0);
+  abaco_vm_settop (vm, 1);
+return 1;
+}
@@ -0,0 +1,279 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <closure.h>
+#include <internal.h>
+
+#define _g_set_row_error(error,row,...) \
+  (g_set_error ((error), ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED, "Row %u: " __VA_ARGS__))
+
+static gboolean
+_load_cell (UclReg* reg, const AbacoMPColumn* column, guint row, GError** error)
+{
+  switch (column->type)
+  {
+  case ABACO_MP_COLUMN_DOUBLE:
+    if (ucl_context_get_fast ())
+    {
+      ucl_reg_setup (reg, UCL_REG_TYPE_DOUBLE);
+      reg->dbl = ((const gdouble*) column->data) [row];
+    }
+    else
+    {
+      ucl_reg_setup (reg, UCL_REG_TYPE_REAL);
+      mpfr_set_d (reg->real, ((const gdouble*) column->data) [row], ucl_context_get_rounding ());
+    }
+    break;
+  case ABACO_MP_COLUMN_INT64:
+    {
+      gint64 value = ((const gint64*) column->data) [row];
+      if (value >= G_MINLONG && value <= G_MAXLONG)
+      {
+        ucl_reg_setup (reg, UCL_REG_TYPE_WORD);
+        reg->word = (glong) value;
+      }
+      else
+      {
+        ucl_reg_setup (reg, UCL_REG_TYPE_INTEGER);
+        mpz_set_si (reg->integer, (glong) (value >> 32));
+        mpz_mul_2exp (reg->integer, reg->integer, 32);
+        mpz_add_ui (reg->integer, reg->integer, (gulong) (value & 0xffffffff));
+      }
+    }
+    break;
+  case ABACO_MP_COLUMN_STRING:
+    {
+      const gchar* value = ((const gchar**) column->data) [row];
+      if (value == NULL || !ucl_reg_load_string (reg, value, 10))
+      {
+        _g_set_row_error (error, row, "invalid value '%s'", value);
+        return FALSE;
+      }
+    }
+    break;
+  case ABACO_MP_COLUMN_REG:
+    ucl_reg_copy (reg, & ((const UclReg*) column->data) [row]);
+    break;
+  default:
+    g_return_val_if_reached (FALSE);
+  }
+return TRUE;
+}
+
+static gboolean
+_save_cell (const UclReg* reg, AbacoMPColumn* column, guint row, GError** error)
+{
+  if (reg->type < UCL_REG_TYPE_WORD
+    || reg->type > UCL_REG_TYPE_REAL)
+  {
+    _g_set_row_error (error, row, "result is not a number");
+    return FALSE;
+  }
+
+  switch (column->type)
+  {
+  case ABACO_MP_COLUMN_DOUBLE:
+    ((gdouble*) column->data) [row] = ucl_reg_save_double (reg);
+    break;
+  case ABACO_MP_COLUMN_INT64:
+    {
+      gint64* values = column->data;
+      switch (reg->type)
+      {
+      case UCL_REG_TYPE_WORD:
+        values [row] = reg->word;
+        break;
+      case UCL_REG_TYPE_INTEGER:
+        if (!mpz_fits_slong_p (reg->integer))
+        {
+          _g_set_row_error (error, row, "result does not fit an integer column");
+          return FALSE;
+        }
+
+        values [row] = mpz_get_si (reg->integer);
+        break;
+      default:
+        {
+          UclReg word = {0};
+          ucl_reg_cast (&word, reg, UCL_REG_TYPE_WORD);
+
+          /* out of range or non-finite values stay wide */
+          if (word.type != UCL_REG_TYPE_WORD)
+          {
+            ucl_reg_unset (&word);
+            _g_set_row_error (error, row, "result does not fit an integer column");
+            return FALSE;
+          }
+
+          values [row] = word.word;
+        }
+        break;
+      }
+    }
+    break;
+  case ABACO_MP_COLUMN_STRING:
+    ((gchar**) column->data) [row] = ucl_reg_save_string (reg, 10);
+    break;
+  case ABACO_MP_COLUMN_REG:
+    ucl_reg_copy (& ((UclReg*) column->data) [row], reg);
+    break;
+  default:
+    g_return_val_if_reached (FALSE);
+  }
+return TRUE;
+}
+
+static gboolean
+_call_rows_program (AbacoMP* self, MpProgram* program, const AbacoMPColumn* columns, guint n_columns, AbacoMPColumn* result, guint n_rows, GError** error)
+{
+  AbacoVM* vm = ABACO_VM (self);
+  MpStack* stack = NULL;
+  gboolean success = TRUE;
+  guint i, row;
+
+  if (n_columns != program->n_arguments)
+  {
+    g_set_error
+    (error,
+     ABACO_MP_ERROR,
+     ABACO_MP_ERROR_FAILED,
+     "Wrong number of columns for function (%u given, %u expected)",
+     n_columns, program->n_arguments);
+    return FALSE;
+  }
+
+  /*
+   * One register file serves every row: arguments
+   * are loaded in place and whatever limbs are left
+   * from the previous row get reused (unless the VM
+   * evaluates on an arena, which resets every row)
+   *
+   */
+
+  stack = _abaco_mp_acquire_frame (self, program->n_registers);
+
+  for (row = 0; row < n_rows && success; row++)
+  {
+    MpArenaScope scope = _abaco_mp_arena_enter (self);
+    gint got = 0;
+
+    for (i = 0; i < n_columns && success; i++)
+      success = _load_cell (_mp_stack_reset_reg (stack, i), &columns [i], row, error);
+    if (success)
+      got = _abaco_mp_execute_on (self, program, stack);
+
+    /* each row is an evaluation of its own */
+    if (scope == MP_ARENA_SCOPE_OPENED)
+      _mp_stack_wipe (stack);
+    _abaco_mp_arena_leave (self, scope, got > 0);
+
+    if (!success)
+      break;
+    if (got > 0)
+    {
+      success = _save_cell (_abaco_mp_toreg (self, -1), result, row, error);
+      abaco_vm_pop (vm);
+    }
+    else
+    {
+      _g_set_row_error (error, row, "function returned no value");
+      success = FALSE;
+    }
+  }
+
+  _abaco_mp_release_frame (self, stack);
+return success;
+}
+
+static gboolean
+_call_rows_generic (AbacoMP* self, gint index, const AbacoMPColumn* columns, guint n_columns, AbacoMPColumn* result, guint n_rows, GError** error)
+{
+  AbacoVM* vm = ABACO_VM (self);
+  gint top = abaco_vm_gettop (vm);
+  gboolean success = TRUE;
+  guint i, row;
+
+  for (row = 0; row < n_rows && success; row++)
+  {
+    abaco_vm_pushvalue (vm, index);
+
+    for (i = 0; i < n_columns && success; i++)
+    {
+      abaco_vm_settop (vm, top + 2 + i);
+      success = _load_cell (_abaco_mp_toreg (self, -1), &columns [i], row, error);
+    }
+
+    if (!success)
+      break;
+    if (abaco_vm_call (vm, n_columns) > 0)
+    {
+      success = _save_cell (_abaco_mp_toreg (self, -1), result, row, error);
+      abaco_vm_pop (vm);
+    }
+    else
+    {
+      _g_set_row_error (error, row, "function returned no value");
+      success = FALSE;
+    }
+  }
+
+  abaco_vm_settop (vm, top);
+return success;
+}
+
+gboolean
+abaco_mp_call_rows (AbacoMP* self, gint index, const AbacoMPColumn* columns, guint n_columns, AbacoMPColumn* result, guint n_rows, GError** error)
+{
+  g_return_val_if_fail (ABACO_IS_MP (self), FALSE);
+  g_return_val_if_fail (columns != NULL || n_columns == 0, FALSE);
+  g_return_val_if_fail (result != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  AbacoVM* vm = ABACO_VM (self);
+  const UclContext* last = NULL;
+  MpClosure* closure = NULL;
+  gboolean success;
+  gint top;
+
+  top = abaco_vm_gettop (vm);
+  if (index < 0)
+    index += top;
+  g_return_val_if_fail (index >= 0 && index < top, FALSE);
+
+  if ((closure = _abaco_mp_peek_closure (self, index)) == NULL)
+  {
+    g_set_error
+    (error,
+     ABACO_MP_ERROR,
+     ABACO_MP_ERROR_FAILED,
+     "Attempt to call a non-function value");
+    return FALSE;
+  }
+
+  last = _abaco_mp_enter (self);
+
+  if (G_TYPE_CHECK_INSTANCE_TYPE (closure, _MP_TYPE_FUNCTION))
+  {
+    MpProgram* program = _mp_function_get_program ((MpFunction*) closure);
+    success = _call_rows_program (self, program, columns, n_columns, result, n_rows, error);
+  }
+  else
+    success = _call_rows_generic (self, index, columns, n_columns, result, n_rows, error);
+
+  ucl_context_leave (last);
+return success;
+}
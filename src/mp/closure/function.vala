@@ -21,19 +21,20 @@ namespace Mp
 {
   public class Function : Closure
   {
-    public GLib.Bytes code { get; private set; }
+    public Program program { get; private set; }
+    public GLib.Bytes code { get { return program.code; } }
 
     public override int invoke (Abaco.MP vm)
     {
-      var result = vm.execute (code);
+      var result = vm.execute (program);
       return result;
     }
 
     [CCode (type = "MpClosure*")]
-    public Function (GLib.Bytes code)
+    public Function (Program program)
     {
       base (null, 0);
-      this.code = code;
+      this.program = program;
     }
   }
 }
@@ -19,327 +19,242 @@
 #include <bytecode.h>
 #include <closure.h>
 #include <internal.h>
+#include <program.h>
 
-typedef struct _MpState MpState;
+/*
+ * Opcode semantics, shared by both dispatch engines
+ *
+ */
 
-struct _MpState
+static inline void
+_mp_op_move (MpStack* stack, guint dst, guint src, guint steal)
 {
-  GBytes* code;
-  MpStack* stack;
-  GPtrArray* strtab;
-  const BSection* stacksect;
-  const BSection* strtabsect;
-};
-
-static inline const BSection*
-_mp_locate_section (GBytes* code, BSectionType type)
+  if (steal)
+    _mp_stack_move (stack, dst, stack, src);
+  else
+    _mp_stack_copy (stack, dst, stack, src);
+}
+
+static inline void
+_mp_op_loadk (MpBinding* binding, MpStack* stack, guint dst, guint src)
+{
+  _mp_stack_copy (stack, dst, binding->constants, src);
+}
+
+static inline void
+_mp_op_loadf (MpProgram* program, MpBinding* binding, MpStack* stack, guint dst, guint src)
 {
-  gconstpointer ptr = NULL;
-  gconstpointer top = NULL;
-  const BSection* section = NULL;
-  gsize length = 0;
+  MpClosure* closure = NULL;
+  GValue* value = NULL;
 
-  ptr = g_bytes_get_data (code, &length);
-  top = ptr + length;
+  if ((closure = binding->functions [src]) == NULL)
+    g_error ("Invalid function '%s'", program->strtab [src]);
 
-  while (ptr < top)
+  value = _mp_stack_reset_value (stack, dst, _MP_TYPE_CLOSURE);
+  _mp_value_set_closure (value, closure);
+}
+
+static inline void
+_mp_op_call (AbacoMP* self, MpStack* stack, guint dst, guint src, guint cnt)
+{
+  if (_abaco_mp_call_frame (self, stack, dst, src, cnt) < 0)
+    g_assert_not_reached ();
+}
+
+static inline gint
+_mp_op_return (AbacoMP* self, MpStack* stack, guint src)
+{
+  _abaco_mp_steal_from (self, stack, src, 1);
+return 1;
+}
+
+/*
+ * Every program is verified when it loads (see
+ * _mp_program_verify), so dispatch runs without any
+ * operand bounds checks; code is straight-line and
+ * ends in RETURN, so it never runs off its end.
+ *
+ */
+
+static gint
+_mp_doexecute (AbacoMP* self, MpProgram* program, MpBinding* binding, MpStack* stack)
+{
+  const BOpcode* opcode = program->entry;
+
+  do
   {
-    section = (BSection*) ptr;
-    if (section->type == type)
-      return section;
-    if (section->flags & B_SECTION_VIRTUAL)
-      ptr += sizeof (BSection);
-    else
+    switch (opcode->code)
     {
-      gsize size = section->size;
-      gsize miss = size % B_SECTION_ALIGN;
-      if (miss > 0)
-        ptr += size + (B_SECTION_ALIGN - miss);
-      else
-        ptr += size;
+    case B_OPCODE_NOP:
+      break;
+    case B_OPCODE_MOVE:
+      _mp_op_move (stack, opcode->abc.a, opcode->abc.b, opcode->abc.c);
+      break;
+    case B_OPCODE_LOADK:
+      _mp_op_loadk (binding, stack, opcode->abx.a, opcode->abx.bx);
+      break;
+    case B_OPCODE_LOADF:
+      _mp_op_loadf (program, binding, stack, opcode->abx.a, opcode->abx.bx);
+      break;
+    case B_OPCODE_CALL:
+      _mp_op_call (self, stack, opcode->abc.a, opcode->abc.b, opcode->abc.c);
+      break;
+    case B_OPCODE_RETURN:
+      return _mp_op_return (self, stack, opcode->abc.a);
+    default:
+      g_assert_not_reached ();
+      break;
     }
+
+    ++opcode;
   }
-return NULL;
+  while (TRUE);
+return 0;
 }
 
-static inline GPtrArray*
-_mp_load_strtab (GBytes* code, const BSection* section)
-{
-  GPtrArray* strtab = NULL;
-  gconstpointer ptr = NULL;
-  gconstpointer top = NULL;
-  gsize length = 0;
+#if MP_THREADED_DISPATCH
 
-  length = g_bytes_get_size (code);
+/*
+ * Direct threaded dispatch: code is translated
+ * once into MpInsn records carrying the handler label
+ * and decoded operands, so every handler jumps straight
+ * to the next one (see _abaco_mp_thread). Called with
+ * a NULL program it just hands out its label table.
+ *
+ */
 
-  if (top >= section->size + (gpointer) section)
-    g_error ("Invalid binary: invalid string table");
+static gint
+_mp_doexecute_threaded (AbacoMP* self, MpProgram* program, MpBinding* binding, MpStack* stack, gconstpointer** plabels)
+{
+  static const gconstpointer labels [B_OPCODE_MAXOPCODE] =
+  {
+    [B_OPCODE_NOP] = &&do_nop,
+    [B_OPCODE_MOVE] = &&do_move,
+    [B_OPCODE_LOADK] = &&do_loadk,
+    [B_OPCODE_LOADF] = &&do_loadf,
+    [B_OPCODE_CALL] = &&do_call,
+    [B_OPCODE_RETURN] = &&do_return,
+  };
 
-  strtab = g_ptr_array_new ();
-  ptr = sizeof (BSection) + (gpointer) section;
-  top = ptr + section->size - sizeof (BSection);
+  const MpInsn* insn = NULL;
 
-  while (ptr < top)
+  if (G_UNLIKELY (program == NULL))
   {
-    g_ptr_array_add (strtab, (gchar*) ptr);
-    ptr += strlen ((gchar*) ptr) + 1;
+    *plabels = (gconstpointer*) labels;
+    return 0;
   }
-return strtab;
+
+#define dispatch() goto *(insn->handler)
+#define next() G_STMT_START { ++insn; dispatch (); } G_STMT_END
+
+  insn = program->insns;
+  dispatch ();
+
+do_nop:
+  next ();
+do_move:
+  _mp_op_move (stack, insn->a, insn->b, insn->c);
+  next ();
+do_loadk:
+  _mp_op_loadk (binding, stack, insn->a, insn->b);
+  next ();
+do_loadf:
+  _mp_op_loadf (program, binding, stack, insn->a, insn->b);
+  next ();
+do_call:
+  _mp_op_call (self, stack, insn->a, insn->b, insn->c);
+  next ();
+do_return:
+  return _mp_op_return (self, stack, insn->a);
+
+#undef dispatch
+#undef next
 }
 
-static inline goffset
-_mp_locate_entry_offset (GBytes* code)
+void
+_abaco_mp_thread (MpProgram* program)
 {
-  gconstpointer ptr = NULL;
-  gconstpointer top = NULL;
-  const BSection* section = NULL;
-  goffset offset = 0;
-  gsize length = 0;
+  const BOpcode* opcode = NULL;
+  gconstpointer* labels = NULL;
+  MpInsn* insn = NULL;
 
-  ptr = g_bytes_get_data (code, &length);
-  top = ptr + length;
+  _mp_doexecute_threaded (NULL, NULL, NULL, NULL, &labels);
 
-  while (ptr < top)
+  program->insns = g_new (MpInsn, program->top - program->entry);
+  for (opcode = program->entry, insn = program->insns; opcode < program->top; opcode++, insn++)
   {
-    section = (BSection*) ptr;
-    if (section->type == B_SECTION_TYPE_BITS
-      && section->flags & B_SECTION_CODE)
-    {
-      if (G_UNLIKELY (offset != 0))
-        return 0;
-      else
-      {
-        goffset start = (goffset) g_bytes_get_data (code, NULL);
-        offset = sizeof (BSection) + (goffset) ptr;
-        offset -= start;
-
-        if (offset > length)
-          return 0;
-      }
-    }
+    insn->handler = labels [opcode->code];
 
-    if (section->flags & B_SECTION_VIRTUAL)
-      ptr += sizeof (BSection);
-    else
+    switch (opcode->code)
     {
-      gsize size = section->size;
-      gsize miss = size % B_SECTION_ALIGN;
-      if (miss > 0)
-        ptr += size + (B_SECTION_ALIGN - miss);
-      else
-        ptr += size;
+    case B_OPCODE_LOADK:
+    case B_OPCODE_LOADF:
+      insn->a = opcode->abx.a;
+      insn->b = opcode->abx.bx;
+      insn->c = 0;
+      break;
+    default:
+      insn->a = opcode->abc.a;
+      insn->b = opcode->abc.b;
+      insn->c = opcode->abc.c;
+      break;
     }
   }
-return offset;
 }
 
-static inline gint
-_mp_doexecute (AbacoMP* self, MpState* state, goffset entry)
+#else // !MP_THREADED_DISPATCH
+
+void
+_abaco_mp_thread (MpProgram* program)
 {
-  const BSection* stacksect = state->stacksect;
-  const BSection* strtabsect = state->strtabsect;
-  GBytes* code = state->code;
-  MpStack* stack = state->stack;
-  GPtrArray* strtab = state->strtab;
-  gconstpointer ptr = NULL;
-  gconstpointer top = NULL;
-  BOpcode* opcode = NULL;
-  gsize length = 0;
-
-  ptr = g_bytes_get_data (code, &length);
-  top = ptr + length;
-  ptr = ptr + entry;
+}
 
-  do
-  {
-    if (G_UNLIKELY (ptr >= top))
-      g_error ("Invalid binary: jump out of code");
-    else
-    {
-      opcode = (BOpcode*) ptr;
-      switch (opcode->code)
-      {
-      case B_OPCODE_NOP:
-        break;
-      case B_OPCODE_MOVE:
-        {
-          guint dst = opcode->abc.a;
-          guint src = opcode->abc.b;
-          if (src >= stacksect->size
-            || dst >= stacksect->size)
-            g_error ("Invalid binary: invalid opcode");
-          else
-          { 
-            _mp_stack_push_index (stack, src);
-            _mp_stack_exchange (stack, dst);
-            _mp_stack_pop (stack, 1);
-          }
-        }
-        break;
-      case B_OPCODE_LOADK:
-        {
-          guint dst = opcode->abx.a;
-          guint src = opcode->abx.bx;
-          const gchar* value = NULL;
-          const gchar* key = NULL;
-          GHashTable* tbl = NULL;
-          gboolean has = FALSE;
-
-          if (src >= strtab->len
-            || dst >= stacksect->size)
-            g_error ("Invalid binary: invalid opcode");
-          else
-          {
-            key = g_ptr_array_index (strtab, src);
-            if ((value = _abaco_mp_lookup_constant (self, key)) == NULL)
-              value = key; 
-
-            if (!_mp_stack_push_string (stack, value, 10))
-              g_error ("Invalid constant '%s'", value);
-
-            _mp_stack_exchange (stack, dst);
-            _mp_stack_pop (stack, 1);
-          }
-        }
-        break;
-      case B_OPCODE_LOADF:
-        {
-          guint dst = opcode->abx.a;
-          guint src = opcode->abx.bx;
-          MpClosure* closure = NULL;
-          const gchar* key = NULL;
-          GHashTable* tbl = NULL;
-          gboolean has = FALSE;
-
-          if (src >= strtab->len
-            || dst >= stacksect->size)
-            g_error ("Invalid binary: invalid opcode");
-          else
-          {
-            key = g_ptr_array_index (strtab, src);
-            if ((closure = _abaco_mp_lookup_function (self, key)) == NULL)
-              g_error ("Invalid function '%s'", key);
-
-            GValue value = G_VALUE_INIT;
-            g_value_init (&value, _MP_TYPE_CLOSURE);
-            _mp_value_set_closure (&value, closure);
-            _mp_stack_push_value (stack, &value);
-            g_value_unset (&value);
-
-            _mp_stack_exchange (stack, dst);
-            _mp_stack_pop (stack, 1);
-          }
-        }
-        break;
-      case B_OPCODE_CALL:
-        {
-          guint dst = opcode->abc.a;
-          guint src = opcode->abc.b;
-          guint cnt = opcode->abc.c;
-          gint result;
-          guint i;
-
-          if (src >= stacksect->size
-            || dst >= stacksect->size
-            || (src + cnt) > stacksect->size)
-            g_error ("Invalid binary: invalid opcode");
-          else
-          {
-            GValue value = G_VALUE_INIT;
-            _mp_stack_peek_value (stack, dst, &value);
-            if (!G_VALUE_HOLDS (&value, _MP_TYPE_CLOSURE))
-              g_error ("Invalid function value");
-            g_value_unset (&value);
-
-            _mp_stack_push_index (stack, dst);
-            _abaco_mp_transfer_from (self, stack);
-            for (i = 0; i < cnt; i++)
-            {
-              _mp_stack_push_index (stack, src + i);
-              _abaco_mp_transfer_from (self, stack);
-            }
-
-            result =
-            abaco_vm_call (ABACO_VM (self), cnt);
-            if (result < 0)
-              g_assert_not_reached ();
-            else
-            if (result > 0)
-            {
-              _abaco_mp_transfer_to (self, stack);
-              _mp_stack_exchange (stack, dst);
-              _mp_stack_pop (stack, 1);
-            }
-          }
-        }
-        break;
-      case B_OPCODE_RETURN:
-        {
-          guint src = opcode->abc.a;
-          if (src >= stacksect->size)
-            g_error ("Invalid binary: invalid opcode");
-          else
-          {
-            _mp_stack_push_index (stack, src);
-            _abaco_mp_transfer_from (self, stack);
-            return 1;
-          }
-        }
-        break;
-      default:
-        g_error ("Invalid binary: invalid opcode");
-        break;
-      }
-
-      ptr += sizeof (BOpcode);
-    }
-  }
-  while (TRUE);
-return 0;
+#endif // MP_THREADED_DISPATCH
+
+gint
+_abaco_mp_execute_on (AbacoMP* self, MpProgram* program, MpStack* stack)
+{
+  MpBinding* binding = NULL;
+  gint result;
+
+  /*
+   * Binding happens once per run rather than on
+   * every LOADK/LOADF; the binding stays pinned
+   * meanwhile, so nested runs can not evict it
+   * from under this one (a re-bind by a nested
+   * run only refreshes its slots in place).
+   *
+   */
+
+  binding = _mp_program_bind (program, self);
+  ++binding->pins;
+
+#if MP_THREADED_DISPATCH
+  if (G_LIKELY (program->insns != NULL && _abaco_mp_get_threaded (self)))
+    result = _mp_doexecute_threaded (self, program, binding, stack, NULL);
+  else
+#endif // MP_THREADED_DISPATCH
+  result = _mp_doexecute (self, program, binding, stack);
+
+  --binding->pins;
+return result;
 }
 
 gint
-_abaco_mp_execute (AbacoMP* self, GBytes* code)
+_abaco_mp_execute (AbacoMP* self, MpProgram* program)
 {
-  const BSection* stacksect = NULL;
-  const BSection* strtabsect = NULL;
-  GPtrArray* strtab = NULL;
   MpStack* stack = NULL;
-  MpState state = {0};
-  goffset entry = 0;
-  guint i, top;
+  guint top;
   gint result;
 
   top = abaco_vm_gettop (ABACO_VM (self));
+  if (G_UNLIKELY (top < program->n_arguments))
+    g_error ("Bad arguments (%u expected, got %u)", program->n_arguments, top);
 
-  if ((stacksect = _mp_locate_section (code, B_SECTION_TYPE_STACK)) == NULL)
-    g_error ("Invalid binary: can't locate stack section");
-  if ((strtabsect = _mp_locate_section (code, B_SECTION_TYPE_STRTAB)) == NULL)
-    g_error ("Invalid binary: can't locate string table");
-  if ((strtab = _mp_load_strtab (code, strtabsect)) == NULL)
-    g_error ("Invalid binary: can't load string table");
-  if ((entry = _mp_locate_entry_offset (code)) == 0)
-    g_error ("Invalid binary: can't locate entry");
-
-  stack = _mp_stack_new ();
-
-  for (i = 0; i < stacksect->size; i++)
-    _mp_stack_push_nil (stack);
-  for (i = 0; i < top; i++)
-  {
-    _abaco_mp_transfer_from (self, stack);
-    _mp_stack_exchange (stack, top - i - 1);
-    _mp_stack_pop (stack, 1);
-  }
-
-  state.code = code;
-  state.stack = stack;
-  state.strtab = strtab;
-  state.stacksect = stacksect;
-  state.strtabsect = strtabsect;
-  result = _mp_doexecute (self, &state, entry);
+  stack = _abaco_mp_acquire_frame (self, MAX (top, program->n_registers));
+  _abaco_mp_steal_frame (self, stack);
 
-  g_ptr_array_unref (strtab);
-  _mp_stack_unref (stack);
+  result = _abaco_mp_execute_on (self, program, stack);
+  _abaco_mp_release_frame (self, stack);
 return result;
 }
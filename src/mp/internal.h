@@ -20,7 +20,10 @@
 #ifndef __LIBABACO_MP_INSIDE__
 # error "This is a private header"
 #endif // __LIBABACO_MP_INSIDE__
+#include <arena.h>
 #include <libabaco_mp.h>
+#include <libabaco_ucl.h>
+#include <program.h>
 #include <value.h>
 
 #define EXPORT G_GNUC_INTERNAL
@@ -39,10 +42,46 @@ EXPORT void
 _abaco_mp_transfer_to (AbacoMP* self, MpStack* dst);
 EXPORT void
 _abaco_mp_transfer_from (AbacoMP* self, MpStack* src);
+EXPORT gpointer
+_abaco_mp_peek_closure (AbacoMP* self, gint index);
+EXPORT UclReg*
+_abaco_mp_toreg (AbacoMP* self, gint index);
+EXPORT void
+_abaco_mp_steal_from (AbacoMP* self, MpStack* src, guint index, guint count);
+EXPORT guint
+_abaco_mp_steal_frame (AbacoMP* self, MpStack* dst);
+EXPORT MpStack*
+_abaco_mp_acquire_frame (AbacoMP* self, guint size);
+EXPORT void
+_abaco_mp_release_frame (AbacoMP* self, MpStack* stack);
 EXPORT const gchar*
 _abaco_mp_lookup_constant (AbacoMP* self, const gchar* key);
 EXPORT gpointer
 _abaco_mp_lookup_function (AbacoMP* self, const gchar* key);
+EXPORT gint
+_abaco_mp_call_frame (AbacoMP* self, MpStack* stack, guint func, guint base, guint count);
+EXPORT guint
+_abaco_mp_get_epoch (AbacoMP* self);
+EXPORT guint
+_abaco_mp_get_constants_epoch (AbacoMP* self);
+EXPORT gsize
+_abaco_mp_get_id (AbacoMP* self);
+EXPORT MpBinding*
+_abaco_mp_get_binding (AbacoMP* self, MpProgram* program);
+EXPORT gboolean
+_abaco_mp_get_threaded (AbacoMP* self);
+EXPORT const UclContext*
+_abaco_mp_enter (AbacoMP* self);
+EXPORT MpArenaScope
+_abaco_mp_arena_enter (AbacoMP* self);
+EXPORT void
+_abaco_mp_arena_leave (AbacoMP* self, MpArenaScope scope, gboolean keep_top);
+EXPORT void
+_abaco_mp_thread (MpProgram* program);
+EXPORT gint
+_abaco_mp_execute_on (AbacoMP* self, MpProgram* program, MpStack* stack);
+EXPORT gint
+_abaco_mp_execute (AbacoMP* self, MpProgram* program);
 
 #if __cplusplus
 }
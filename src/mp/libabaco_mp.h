@@ -35,6 +35,30 @@
 #define ABACO_IS_MP(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), ABACO_TYPE_MP))
 typedef struct _AbacoMP AbacoMP;
 
+#define ABACO_MP_ERROR (abaco_mp_error_quark ())
+
+typedef enum
+{
+  ABACO_MP_ERROR_FAILED,
+  ABACO_MP_ERROR_INVALID_BINARY,
+} AbacoMPError;
+
+typedef struct _AbacoMPColumn AbacoMPColumn;
+
+typedef enum
+{
+  ABACO_MP_COLUMN_DOUBLE,   /* gdouble*     */
+  ABACO_MP_COLUMN_INT64,    /* gint64*      */
+  ABACO_MP_COLUMN_STRING,   /* gchar**      */
+  ABACO_MP_COLUMN_REG,      /* UclReg*      */
+} AbacoMPColumnType;
+
+struct _AbacoMPColumn
+{
+  AbacoMPColumnType type;
+  gpointer data;
+};
+
 #define ABACO_ASSOC_LEFT FALSE
 #define ABACO_ASSOC_RIGHT TRUE
 
@@ -42,6 +66,7 @@ typedef struct _AbacoMP AbacoMP;
 #define MP_TYPE_VALUE (__type_value__ ())
 #define MP_TYPE_INTEGER (__type_integer__ ())
 #define MP_TYPE_RATIONAL (__type_rational__ ())
+#define MP_TYPE_DOUBLE (__type_double__ ())
 #define MP_TYPE_REAL (__type_real__ ())
 
 #if __cplusplus
@@ -56,6 +81,10 @@ extern "C" {
   (G_GNUC_EXTENSION ({ \
     abaco_mp_typename ((self), (index)) == MP_TYPE_RATIONAL; \
   }))
+#define abaco_mp_isdouble(self,index) \
+  (G_GNUC_EXTENSION ({ \
+    abaco_mp_typename ((self), (index)) == MP_TYPE_DOUBLE; \
+  }))
 #define abaco_mp_isreal(self,index) \
   (G_GNUC_EXTENSION ({ \
     abaco_mp_typename ((self), (index)) == MP_TYPE_REAL; \
@@ -66,9 +95,12 @@ extern "C" {
     gint __index = (index); \
     abaco_mp_isinteger (__self, __index) || \
     abaco_mp_isrational (__self, __index) || \
+    abaco_mp_isdouble (__self, __index) || \
     abaco_mp_isreal (__self, __index); \
   }))
 
+MP_EXPORT GQuark
+abaco_mp_error_quark (void);
 MP_EXPORT GType
 abaco_mp_get_type (void) G_GNUC_CONST;
 MP_EXPORT AbacoVM*
@@ -77,6 +109,8 @@ MP_EXPORT AbacoVM*
 abaco_mp_new_naked (void);
 MP_EXPORT void
 abaco_mp_load_stdlib (AbacoMP* self);
+MP_EXPORT AbacoCache*
+abaco_mp_get_cache (AbacoMP* self);
 MP_EXPORT const gchar*
 abaco_mp_typename (AbacoMP* self, gint index);
 MP_EXPORT gboolean
@@ -93,12 +127,16 @@ MP_EXPORT long double
 abaco_mp_toldouble (AbacoMP* self, gint index);
 MP_EXPORT gchar*
 abaco_mp_tostring (AbacoMP* self, gint index, int base);
+MP_EXPORT gsize
+abaco_mp_tobuffer (AbacoMP* self, gint index, GString* buffer, int base);
 MP_EXPORT mpz_ptr
 abaco_mp_tointeger (AbacoMP* self, gint index);
 MP_EXPORT mpq_ptr
 abaco_mp_torational (AbacoMP* self, gint index);
 MP_EXPORT mpfr_ptr
 abaco_mp_toreal (AbacoMP* self, gint index);
+MP_EXPORT gboolean
+abaco_mp_call_rows (AbacoMP* self, gint index, const AbacoMPColumn* columns, guint n_columns, AbacoMPColumn* result, guint n_rows, GError** error);
 
 /*
  * Types
@@ -109,6 +147,7 @@ MP_EXPORT const gchar* __type_nil__ (void) G_GNUC_CONST;
 MP_EXPORT const gchar* __type_value__ (void) G_GNUC_CONST;
 MP_EXPORT const gchar* __type_integer__ (void) G_GNUC_CONST;
 MP_EXPORT const gchar* __type_rational__ (void) G_GNUC_CONST;
+MP_EXPORT const gchar* __type_double__ (void) G_GNUC_CONST;
 MP_EXPORT const gchar* __type_real__ (void) G_GNUC_CONST;
 
 /*
@@ -120,8 +159,10 @@ MP_EXPORT int abaco_mp_arith_add (AbacoVM* vm);
 MP_EXPORT int abaco_mp_arith_sub (AbacoVM* vm);
 MP_EXPORT int abaco_mp_arith_mul (AbacoVM* vm);
 MP_EXPORT int abaco_mp_arith_div (AbacoVM* vm);
+MP_EXPORT int abaco_mp_arith_fma (AbacoVM* vm);
 MP_EXPORT int abaco_mp_power_sqrt (AbacoVM* vm);
 MP_EXPORT int abaco_mp_power_cbrt (AbacoVM* vm);
+MP_EXPORT int abaco_mp_power_rootn (AbacoVM* vm);
 MP_EXPORT int abaco_mp_power_pow (AbacoVM* vm);
 
 #if __cplusplus
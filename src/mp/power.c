@@ -19,29 +19,28 @@
 #include <libabaco_ucl.h>
 #include <internal.h>
 
-int
-abaco_mp_power_sqrt (AbacoVM* vm)
-{
-  if (!ABACO_IS_MP (vm))
-g_error ("Incompatible Virtual Machine");
-
-  AbacoMP* mp = ABACO_MP (vm);
-  if (!abaco_mp_isnumber (mp, 0))
-    g_error ("Bad argument #0 (integer, rational or real expected, got %s)",
-      abaco_mp_typename (mp, 0));
-
-  abaco_mp_pushstring (mp, "1/2", 10);
-  abaco_vm_insert (vm, 0);
-
-  UclReg* accum = (UclReg*) abaco_mp_tointeger (mp, 0);
-  UclReg* next = (UclReg*) abaco_mp_tointeger (mp, 1);
-  ucl_power_pow (accum, next);
-  abaco_vm_pop (vm);
-return 1;
+#define root(name) \
+int \
+abaco_mp_power_##name (AbacoVM* vm) \
+{ \
+  if (!ABACO_IS_MP (vm)) \
+g_error ("Incompatible Virtual Machine"); \
+ ; \
+  AbacoMP* mp = ABACO_MP (vm); \
+  if (!abaco_mp_isnumber (mp, 0)) \
+    g_error ("Bad argument #0 (integer, rational or real expected, got %s)", \
+      abaco_mp_typename (mp, 0)); \
+ ; \
+  ucl_power_##name (_abaco_mp_toreg (mp, 0)); \
+  abaco_vm_settop (vm, 1); \
+return 1; \
 }
 
+root (sqrt)
+root (cbrt)
+
 int
-abaco_mp_power_cbrt (AbacoVM* vm)
+abaco_mp_power_rootn (AbacoVM* vm)
 {
   if (!ABACO_IS_MP (vm))
 g_error ("Incompatible Virtual Machine");
@@ -51,13 +50,26 @@ g_error ("Incompatible Virtual Machine");
     g_error ("Bad argument #0 (integer, rational or real expected, got %s)",
       abaco_mp_typename (mp, 0));
 
-  abaco_mp_pushstring (mp, "1/3", 10);
-  abaco_vm_insert (vm, 0);
+  UclReg* degree = _abaco_mp_toreg (mp, 1);
+  gulong n = 0;
+
+  /* fast VMs load integral degrees as doubles */
+  if (degree->type == UCL_REG_TYPE_WORD && degree->word > 0)
+    n = (gulong) degree->word;
+  else
+  if (degree->type == UCL_REG_TYPE_INTEGER && mpz_sgn (degree->integer) > 0
+    && mpz_fits_ulong_p (degree->integer))
+    n = mpz_get_ui (degree->integer);
+  else
+  if (degree->type == UCL_REG_TYPE_DOUBLE && degree->dbl >= 1
+    && degree->dbl <= G_MAXULONG && degree->dbl == (gulong) degree->dbl)
+    n = (gulong) degree->dbl;
+  else
+    g_error ("Bad argument #1 (positive integer expected, got %s)",
+      abaco_mp_typename (mp, 1));
 
-  UclReg* accum = (UclReg*) abaco_mp_tointeger (mp, 0);
-  UclReg* next = (UclReg*) abaco_mp_tointeger (mp, 1);
-  ucl_power_pow (accum, next);
-  abaco_vm_pop (vm);
+  ucl_power_rootn (_abaco_mp_toreg (mp, 0), n);
+  abaco_vm_settop (vm, 1);
 return 1;
 }
 
@@ -75,8 +87,8 @@ g_error ("Incompatible Virtual Machine");
     g_error ("Bad argument #1 (integer, rational or real expected, got %s)",
       abaco_mp_typename (mp, 1));
 
-  UclReg* base = (UclReg*) abaco_mp_tointeger (mp, 0);
-  UclReg* exp = (UclReg*) abaco_mp_tointeger (mp, 1);
+  UclReg* base = _abaco_mp_toreg (mp, 0);
+  UclReg* exp = _abaco_mp_toreg (mp, 1);
   ucl_power_pow (exp, base);
 return 1;
 }
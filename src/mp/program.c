@@ -0,0 +1,497 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <closure.h>
+#include <internal.h>
+#include <program.h>
+
+static inline gconstpointer
+_mp_next_section (const BSection* section)
+{
+  gconstpointer ptr = section;
+
+  if (section->flags & B_SECTION_VIRTUAL)
+    ptr += sizeof (BSection);
+  else
+  {
+    gsize size = section->size;
+    gsize miss = size % B_SECTION_ALIGN;
+    if (miss > 0)
+      ptr += size + (B_SECTION_ALIGN - miss);
+    else
+      ptr += size;
+  }
+return ptr;
+}
+
+#define _g_set_binary_error(error,...) \
+  (g_set_error ((error), ABACO_MP_ERROR, ABACO_MP_ERROR_INVALID_BINARY, __VA_ARGS__))
+
+static inline gboolean
+_mp_program_locate (MpProgram* self, GError** error)
+{
+  gconstpointer ptr = NULL;
+  gconstpointer top = NULL;
+  const BSection* section = NULL;
+  gsize length = 0;
+
+  ptr = g_bytes_get_data (self->code, &length);
+  top = ptr + length;
+
+  while (ptr < top)
+  {
+    section = (BSection*) ptr;
+    if (sizeof (BSection) > (top - ptr))
+    {
+      _g_set_binary_error (error, "Invalid binary: truncated section");
+      return FALSE;
+    }
+
+    switch (section->type)
+    {
+    case B_SECTION_TYPE_BITS:
+      if (section->flags & B_SECTION_CODE)
+      {
+        if (G_UNLIKELY (self->codesect != NULL))
+        {
+          _g_set_binary_error (error, "Invalid binary: can't locate entry");
+          return FALSE;
+        }
+
+        self->codesect = section;
+      }
+      break;
+    case B_SECTION_TYPE_STACK:
+      if (self->stacksect == NULL)
+        self->stacksect = section;
+      break;
+    case B_SECTION_TYPE_STRTAB:
+      if (self->strtabsect == NULL)
+        self->strtabsect = section;
+      break;
+    }
+
+    ptr = _mp_next_section (section);
+  }
+
+  if ((section = self->stacksect) == NULL)
+  {
+    _g_set_binary_error (error, "Invalid binary: can't locate stack section");
+    return FALSE;
+  }
+  else
+    self->n_registers = section->size;
+
+  if ((section = self->strtabsect) == NULL)
+  {
+    _g_set_binary_error (error, "Invalid binary: can't locate string table");
+    return FALSE;
+  }
+  else
+  if (section->size < sizeof (BSection)
+    || (gconstpointer) section + section->size > top)
+  {
+    _g_set_binary_error (error, "Invalid binary: invalid string table");
+    return FALSE;
+  }
+
+  if ((section = self->codesect) == NULL
+    || section->size < sizeof (BSection)
+    || (gconstpointer) section + section->size > top
+    || (section->size - sizeof (BSection)) % sizeof (BOpcode) != 0)
+  {
+    _g_set_binary_error (error, "Invalid binary: can't locate entry");
+    return FALSE;
+  }
+  else
+  {
+    ptr = sizeof (BSection) + (gconstpointer) section;
+    top = section->size + (gconstpointer) section;
+    self->entry = (const BOpcode*) ptr;
+    self->top = (const BOpcode*) top;
+  }
+return TRUE;
+}
+
+static inline gboolean
+_mp_program_load_strtab (MpProgram* self, GError** error)
+{
+  const BSection* section = self->strtabsect;
+  GPtrArray* strtab = NULL;
+  gconstpointer ptr = NULL;
+  gconstpointer top = NULL;
+
+  strtab = g_ptr_array_new ();
+  ptr = sizeof (BSection) + (gconstpointer) section;
+  top = section->size + (gconstpointer) section;
+
+  while (ptr < top)
+  {
+    if (memchr (ptr, 0, top - ptr) == NULL)
+    {
+      _g_set_binary_error (error, "Invalid binary: invalid string table");
+      g_ptr_array_unref (strtab);
+      return FALSE;
+    }
+
+    g_ptr_array_add (strtab, (gchar*) ptr);
+    ptr += strlen ((gchar*) ptr) + 1;
+  }
+
+  self->n_strings = strtab->len;
+  self->strtab = (const gchar**) g_ptr_array_free (strtab, FALSE);
+return TRUE;
+}
+
+static guint
+_mp_program_arity (MpProgram* self)
+{
+  guint8* written = g_new0 (guint8, self->n_registers);
+  const BOpcode* opcode = NULL;
+  guint n_arguments = 0;
+  guint i;
+
+  /*
+   * Arguments are whatever registers get read
+   * before anything writes them; callers must
+   * supply at least that many, since registers
+   * past the arguments come from a frame pool and
+   * may still hold a previous call's values.
+   *
+   */
+
+#define _read(reg) \
+  G_STMT_START { \
+    if (!written [(reg)] && (reg) >= n_arguments) \
+      n_arguments = (reg) + 1; \
+  } G_STMT_END
+
+  for (opcode = self->entry; opcode < self->top; opcode++)
+  {
+    switch (opcode->code)
+    {
+    case B_OPCODE_NOP:
+      break;
+    case B_OPCODE_MOVE:
+      _read (opcode->abc.b);
+      written [opcode->abc.a] = TRUE;
+      if (opcode->abc.c)
+        written [opcode->abc.b] = TRUE;
+      break;
+    case B_OPCODE_LOADK:
+    case B_OPCODE_LOADF:
+      written [opcode->abx.a] = TRUE;
+      break;
+    case B_OPCODE_CALL:
+      _read (opcode->abc.a);
+      for (i = 0; i < opcode->abc.c; i++)
+        _read (opcode->abc.b + i);
+      for (i = 0; i < opcode->abc.c; i++)
+        written [opcode->abc.b + i] = TRUE;
+      written [opcode->abc.a] = TRUE;
+      break;
+    case B_OPCODE_RETURN:
+      _read (opcode->abc.a);
+      opcode = self->top - 1;
+      break;
+    }
+  }
+
+#undef _read
+  g_free (written);
+return n_arguments;
+}
+
+static inline gboolean
+_mp_program_verify (MpProgram* self, GError** error)
+{
+  const guint n_registers = self->n_registers;
+  const guint n_strings = self->n_strings;
+  const BOpcode* opcode = NULL;
+
+  /*
+   * Code is straight-line (there are no jumps), so
+   * checking every operand once here and requiring
+   * a trailing RETURN is enough for the dispatch
+   * loop to run without any bounds checks.
+   *
+   */
+
+  for (opcode = self->entry; opcode < self->top; opcode++)
+  {
+    gboolean valid = FALSE;
+
+    switch (opcode->code)
+    {
+    case B_OPCODE_NOP:
+      valid = TRUE;
+      break;
+    case B_OPCODE_MOVE:
+      valid = opcode->abc.a < n_registers
+           && opcode->abc.b < n_registers;
+      break;
+    case B_OPCODE_LOADK:
+    case B_OPCODE_LOADF:
+      valid = opcode->abx.a < n_registers
+           && opcode->abx.bx < n_strings;
+      break;
+    case B_OPCODE_CALL:
+      valid = opcode->abc.a < n_registers
+           && opcode->abc.b < n_registers
+           && opcode->abc.b + opcode->abc.c <= n_registers;
+      break;
+    case B_OPCODE_RETURN:
+      valid = opcode->abc.a < n_registers;
+      break;
+    }
+
+    if (G_UNLIKELY (!valid))
+    {
+      _g_set_binary_error (error, "Invalid binary: invalid opcode at %u",
+                           (guint) (opcode - self->entry));
+      return FALSE;
+    }
+  }
+
+  if (self->entry == self->top
+    || self->top [-1].code != B_OPCODE_RETURN)
+  {
+    _g_set_binary_error (error, "Invalid binary: missing return");
+    return FALSE;
+  }
+
+  self->n_arguments = _mp_program_arity (self);
+return TRUE;
+}
+
+static gboolean
+_mp_program_load_constants (MpProgram* self, MpBinding* binding, AbacoMP* vm, GError** error)
+{
+  const UclContext* last = NULL;
+  const BOpcode* opcode = NULL;
+  MpArenaScope scope;
+  MpStack* pool = NULL;
+  guint i;
+
+  /*
+   * Pool slots mirror string table indices, so
+   * LOADK's Bx operand addresses both. Slots which
+   * are never loaded as constants stay nil. Literals
+   * take the VM context (doubles on fast VMs) and
+   * named constants as they are when the pool is
+   * built, and never an evaluation arena, since the
+   * pool outlives it; changing either bumps the VM
+   * constants epoch, which rebuilds the pool on the
+   * next LOADK.
+   *
+   */
+
+  pool = _mp_stack_new ();
+  for (i = 0; i < self->n_strings; i++)
+    _mp_stack_push_nil (pool);
+  last = _abaco_mp_enter (vm);
+  scope = _mp_arena_enter (NULL);
+
+  for (opcode = self->entry; opcode < self->top; opcode++)
+  {
+    if (opcode->code == B_OPCODE_LOADK)
+    {
+      guint src = opcode->abx.bx;
+      const gchar* value = NULL;
+      const gchar* key = NULL;
+
+      if (_mp_stack_type (pool, src) != MP_TYPE_NIL)
+        continue;
+
+      key = self->strtab [src];
+      if ((value = _abaco_mp_lookup_constant (vm, key)) == NULL)
+        value = key;
+
+      if (!_mp_stack_push_string (pool, value, 10))
+      {
+        g_set_error
+        (error,
+         ABACO_MP_ERROR,
+         ABACO_MP_ERROR_FAILED,
+         "Invalid constant '%s'", value);
+        _mp_arena_leave (scope);
+        ucl_context_leave (last);
+        _mp_stack_unref (pool);
+        return FALSE;
+      }
+
+      _mp_stack_exchange (pool, src);
+      _mp_stack_pop (pool, 1);
+    }
+  }
+
+  _mp_arena_leave (scope);
+  ucl_context_leave (last);
+
+  g_clear_pointer (&binding->constants, _mp_stack_unref);
+  binding->constants = pool;
+  binding->cepoch = _abaco_mp_get_constants_epoch (vm);
+return TRUE;
+}
+
+static void
+_mp_binding_release (MpBinding* binding)
+{
+  guint i;
+  if (binding->functions != NULL)
+  for (i = 0; i < binding->n_functions; i++)
+  if (binding->functions [i] != NULL)
+  {
+    _mp_closure_unref (binding->functions [i]);
+    binding->functions [i] = NULL;
+  }
+}
+
+static void
+_mp_binding_clear (MpBinding* binding)
+{
+  _mp_binding_release (binding);
+  g_clear_pointer (&binding->functions, g_free);
+  g_clear_pointer (&binding->constants, _mp_stack_unref);
+}
+
+static void
+_mp_program_clear (gpointer pself)
+{
+  MpProgram* self = pself;
+  _mp_binding_clear (&self->binding);
+  g_free (self->insns);
+  g_bytes_unref (self->code);
+  g_free (self->strtab);
+}
+
+MpProgram*
+_mp_program_new (AbacoMP* vm, GBytes* code, GError** error)
+{
+  g_return_val_if_fail (ABACO_IS_MP (vm), NULL);
+  g_return_val_if_fail (code != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+  MpProgram* self = g_atomic_rc_box_new0 (MpProgram);
+
+  self->code = g_bytes_ref (code);
+  if (!_mp_program_locate (self, error)
+    || !_mp_program_load_strtab (self, error)
+    || !_mp_program_verify (self, error)
+    || !_mp_program_load_constants (self, &self->binding, vm, error))
+  {
+    _mp_program_unref (self);
+    return NULL;
+  }
+
+  _abaco_mp_thread (self);
+  self->owner = _abaco_mp_get_id (vm);
+  _mp_program_bind (self, vm);
+return self;
+}
+
+static void
+_mp_program_resolve (MpProgram* self, MpBinding* binding, AbacoMP* vm)
+{
+  const BOpcode* opcode = NULL;
+  MpClosure* closure = NULL;
+
+  /*
+   * Function slots are indexed like the constant
+   * pool and hold a reference on whatever closure
+   * was registered under that name at the time of
+   * resolution. Registering a function or operator
+   * bumps the VM epoch, which forces a re-resolve
+   * on the next LOADF.
+   *
+   */
+
+  if (binding->functions == NULL)
+  {
+    binding->functions = g_new0 (gpointer, self->n_strings);
+    binding->n_functions = self->n_strings;
+  }
+  else
+    _mp_binding_release (binding);
+
+  for (opcode = self->entry; opcode < self->top; opcode++)
+  {
+    if (opcode->code == B_OPCODE_LOADF)
+    {
+      guint src = opcode->abx.bx;
+
+      if (binding->functions [src] != NULL)
+        continue;
+      if ((closure = _abaco_mp_lookup_function (vm, self->strtab [src])) != NULL)
+        binding->functions [src] = _mp_closure_ref (closure);
+    }
+  }
+
+  binding->epoch = _abaco_mp_get_epoch (vm);
+}
+
+MpBinding*
+_mp_program_bind (MpProgram* self, AbacoMP* vm)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (ABACO_IS_MP (vm), NULL);
+  MpBinding* binding = NULL;
+
+  /*
+   * Programs are shared (and refcounted atomically),
+   * so only the VM which loaded one (known by its id,
+   * since addresses get reused) resolves into it; any
+   * other VM keeps its own binding for the program
+   *
+   */
+
+  if (G_LIKELY (self->owner == _abaco_mp_get_id (vm)))
+    binding = & self->binding;
+  else
+    binding = _abaco_mp_get_binding (vm, self);
+
+  if (G_UNLIKELY (binding->epoch != _abaco_mp_get_epoch (vm)))
+    _mp_program_resolve (self, binding, vm);
+  if (G_UNLIKELY (binding->cepoch != _abaco_mp_get_constants_epoch (vm)))
+  {
+    GError* tmp_err = NULL;
+    if (!_mp_program_load_constants (self, binding, vm, &tmp_err))
+      g_error ("%s", tmp_err->message);
+  }
+return binding;
+}
+
+void
+_mp_binding_free (MpBinding* binding)
+{
+  _mp_binding_clear (binding);
+  g_slice_free (MpBinding, binding);
+}
+
+MpProgram*
+_mp_program_ref (MpProgram* self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+return g_atomic_rc_box_acquire (self);
+}
+
+void
+_mp_program_unref (MpProgram* self)
+{
+  g_return_if_fail (self != NULL);
+  g_atomic_rc_box_release_full (self, _mp_program_clear);
+}
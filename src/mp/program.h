@@ -0,0 +1,95 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __MP_PROGRAM__
+#define __MP_PROGRAM__ 1
+#ifndef __LIBABACO_MP_INSIDE__
+# error "This is a private header"
+#endif // __LIBABACO_MP_INSIDE__
+#include <bytecode.h>
+#include <glib.h>
+#include <libabaco_mp.h>
+#include <value.h>
+
+#define EXPORT G_GNUC_INTERNAL
+typedef struct _MpBinding MpBinding;
+typedef struct _MpProgram MpProgram;
+typedef struct _MpInsn MpInsn;
+
+#if THREADED_DISPATCH && defined (__GNUC__)
+# define MP_THREADED_DISPATCH 1
+#else // !THREADED_DISPATCH
+# define MP_THREADED_DISPATCH 0
+#endif // THREADED_DISPATCH
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+struct _MpInsn
+{
+  gconstpointer handler;
+  guint a, b, c;
+};
+
+struct _MpBinding
+{
+  MpStack* constants;
+  gpointer* functions;
+  guint n_functions;
+  guint cepoch;
+  guint epoch;
+  guint pins;
+  GList link;
+};
+
+struct _MpProgram
+{
+  GBytes* code;
+  const BSection* stacksect;
+  const BSection* strtabsect;
+  const BSection* codesect;
+  const BOpcode* entry;
+  const BOpcode* top;
+  const gchar** strtab;
+  guint n_strings;
+  guint n_registers;
+  guint n_arguments;
+
+  /*<private>*/
+  MpInsn* insns;
+  MpBinding binding;
+  gsize owner;
+};
+
+EXPORT MpProgram*
+_mp_program_new (AbacoMP* vm, GBytes* code, GError** error);
+EXPORT MpBinding*
+_mp_program_bind (MpProgram* program, AbacoMP* vm);
+EXPORT void
+_mp_binding_free (MpBinding* binding);
+EXPORT MpProgram*
+_mp_program_ref (MpProgram* program);
+EXPORT void
+_mp_program_unref (MpProgram* program);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#undef EXPORT
+#endif // __MP_PROGRAM__
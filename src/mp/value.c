@@ -22,13 +22,19 @@
 
 typedef struct _MpValue MpValue;
 
+static const gchar __integer__[] = "integer";
+
+/* words are integers to the outside world */
+
 static const
 gchar* __type_table__[] =
 {
   "nil",
   "value",
-  "integer",
+  __integer__,
+  __integer__,
   "rational",
+  "double",
   "real",
 };
 
@@ -36,8 +42,10 @@ typedef enum
 {
   MP_TYPE_NIL = UCL_REG_TYPE_VOID,          /* empty slot       */
   MP_TYPE_VALUE = UCL_REG_TYPE_POINTER,     /* arbitrary value  */
+  MP_TYPE_WORD = UCL_REG_TYPE_WORD,         /* small integer    */
   MP_TYPE_INTEGER = UCL_REG_TYPE_INTEGER,
   MP_TYPE_RATIONAL = UCL_REG_TYPE_RATIONAL,
+  MP_TYPE_DOUBLE = UCL_REG_TYPE_DOUBLE,     /* native double    */
   MP_TYPE_REAL = UCL_REG_TYPE_REAL,
   MP_TYPE_MAX,
 } MpType;
@@ -46,16 +54,18 @@ const gchar* __type_nil__ (void) { return __type_table__ [MP_TYPE_NIL]; }
 const gchar* __type_value__ (void) { return __type_table__ [MP_TYPE_VALUE]; }
 const gchar* __type_integer__ (void) { return __type_table__ [MP_TYPE_INTEGER]; }
 const gchar* __type_rational__ (void) { return __type_table__ [MP_TYPE_RATIONAL]; }
+const gchar* __type_double__ (void) { return __type_table__ [MP_TYPE_DOUBLE]; }
 const gchar* __type_real__ (void) { return __type_table__ [MP_TYPE_REAL]; }
 G_STATIC_ASSERT (G_N_ELEMENTS (__type_table__) == MP_TYPE_MAX);
 
+/* scans backwards, so 'integer' resolves to mpz, not word */
 #define _mp_lookup_type(type) \
   (gint) \
   (G_GNUC_EXTENSION ({ \
     const gchar* __type = (type); \
     gint top = G_N_ELEMENTS (__type_table__); \
     gint i, got = -1; \
-    for (i = 0; i < top; i++) \
+    for (i = top - 1; i >= 0; i--) \
     { \
       if (__type_table__ [i] == __type) \
       { \
@@ -90,6 +100,8 @@ G_STATIC_ASSERT (G_STRUCT_OFFSET (MpValue, integer) == G_STRUCT_OFFSET (UclReg,
 G_STATIC_ASSERT (G_STRUCT_OFFSET (MpValue, rational) == G_STRUCT_OFFSET (UclReg, rational));
 G_STATIC_ASSERT (G_STRUCT_OFFSET (MpValue, real) == G_STRUCT_OFFSET (UclReg, real));
 G_STATIC_ASSERT (G_STRUCT_OFFSET (MpValue, type) == G_STRUCT_OFFSET (UclReg, type));
+/* stack slices double as UclReg arrays */
+G_STATIC_ASSERT (sizeof (MpValue) == sizeof (UclReg));
 
 struct _MpStack
 {
@@ -188,6 +200,28 @@ _mp_stack_transfer (MpStack* dst, MpStack* src)
   }
 }
 
+void
+_mp_stack_steal (MpStack* dst, MpStack* src, int from, int count)
+{
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (dst != NULL && dst != src);
+  g_return_if_fail (from >= 0 && count >= 0);
+  g_return_if_fail (src->length >= (guint) (from + count));
+  GArray* adst = (gpointer) dst;
+  MpValue* pmp = & src->values [from];
+  int i;
+
+  /*
+   * Moves registers bitwise, no limbs are copied;
+   * stolen slots are left as clean nils
+   *
+   */
+
+  g_array_append_vals (adst, pmp, count);
+  for (i = 0; i < count; i++)
+    pmp [i] = __clean__;
+}
+
 gboolean
 _mp_stack_cast (MpStack* stack, int index, const gchar* dst_)
 {
@@ -202,7 +236,7 @@ _mp_stack_cast (MpStack* stack, int index, const gchar* dst_)
 
   if (pmp->type != dst)
   {
-    if ((src < MP_TYPE_INTEGER
+    if ((src < MP_TYPE_WORD
       || src > MP_TYPE_REAL)
      || (dst < MP_TYPE_INTEGER
       || dst > MP_TYPE_REAL))
@@ -249,6 +283,69 @@ _mp_stack_push_index (MpStack* stack, int index)
   }
 }
 
+void
+_mp_stack_copy (MpStack* stack, int index, MpStack* src, int from)
+{
+  g_return_if_fail (stack != NULL);
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (index >= 0 && stack->length > index);
+  g_return_if_fail (from >= 0 && src->length > from);
+  MpValue* pmp1 = & stack->values [index];
+  MpValue* pmp2 = & src->values [from];
+
+  if (pmp1 == pmp2)
+    return;
+  if (pmp1->type == MP_TYPE_VALUE)
+    _mp_stack_notify (pmp1);
+
+  switch (pmp2->type)
+  {
+  case MP_TYPE_VALUE:
+    ucl_reg_unset ((UclReg*) pmp1);
+    *pmp1 = __clean__;
+    pmp1->type = MP_TYPE_VALUE;
+    g_value_init (& pmp1->value, G_VALUE_TYPE (& pmp2->value));
+    g_value_copy (& pmp2->value, & pmp1->value);
+    break;
+  default:
+    /* reuses destination storage when types match */
+    ucl_reg_copy ((UclReg*) pmp1, (UclReg*) pmp2);
+    break;
+  }
+}
+
+void
+_mp_stack_move (MpStack* stack, int index, MpStack* src, int from)
+{
+  g_return_if_fail (stack != NULL);
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (index >= 0 && stack->length > index);
+  g_return_if_fail (from >= 0 && src->length > from);
+  MpValue* pmp1 = & stack->values [index];
+  MpValue* pmp2 = & src->values [from];
+
+  if (pmp1 == pmp2)
+    return;
+
+  _mp_stack_notify (pmp1);
+  *pmp1 = *pmp2;
+  *pmp2 = __clean__;
+}
+
+void
+_mp_stack_swap (MpStack* stack, int index1, int index2)
+{
+  g_return_if_fail (stack != NULL);
+  g_return_if_fail (index1 >= 0 && stack->length > index1);
+  g_return_if_fail (index2 >= 0 && stack->length > index2);
+  MpValue* pmp1 = & stack->values [index1];
+  MpValue* pmp2 = & stack->values [index2];
+  MpValue tmp = *pmp1;
+
+  *pmp1 = *pmp2;
+  *pmp2 = tmp;
+}
+
 void
 _mp_stack_exchange (MpStack* stack, int index)
 {
@@ -325,7 +422,7 @@ _mp_stack_new_real (MpStack* stack)
   g_return_if_fail (stack != NULL);
   GArray* array = (gpointer) stack;
   MpValue mp = { .type = MP_TYPE_REAL };
-  mpfr_init (mp.real);
+  mpfr_init2 (mp.real, ucl_context_get_precision ());
   g_array_append_val (array, mp);
 }
 
@@ -352,6 +449,24 @@ _mp_stack_push_value (MpStack* stack, const GValue* value)
   g_array_append_val (array, mp);
 }
 
+GValue*
+_mp_stack_reset_value (MpStack* stack, int index, GType type)
+{
+  g_return_val_if_fail (stack != NULL, NULL);
+  g_return_val_if_fail (index >= 0 && stack->length > index, NULL);
+  MpValue* pmp = & stack->values [index];
+
+  if (pmp->type != MP_TYPE_VALUE
+    || G_VALUE_TYPE (& pmp->value) != type)
+  {
+    _mp_stack_notify (pmp);
+    *pmp = __clean__;
+    pmp->type = MP_TYPE_VALUE;
+    g_value_init (& pmp->value, type);
+  }
+return & pmp->value;
+}
+
 gboolean
 _mp_stack_push_string (MpStack* stack, const gchar* value, int base)
 {
@@ -375,10 +490,19 @@ _mp_stack_push_double (MpStack* stack, double value)
   GArray* array = (gpointer) stack;
   mpfr_rnd_t mode;
 
-  MpValue mp;
+  MpValue mp = {0};
+  if (ucl_context_get_fast ())
+  {
+    mp.type = MP_TYPE_DOUBLE;
+    mp.ucl.dbl = value;
+    g_array_append_val (array, mp);
+    return;
+  }
+
   mp.type = MP_TYPE_REAL;
-  mode = mpfr_get_default_rounding_mode ();
-  mpfr_init_set_d (mp.real, value, mode);
+  mode = ucl_context_get_rounding ();
+  mpfr_init2 (mp.real, ucl_context_get_precision ());
+  mpfr_set_d (mp.real, value, mode);
   g_array_append_val (array, mp);
 }
 
@@ -389,10 +513,19 @@ _mp_stack_push_ldouble (MpStack* stack, long double value)
   GArray* array = (gpointer) stack;
   mpfr_rnd_t mode;
 
-  MpValue mp;
+  MpValue mp = {0};
+  if (ucl_context_get_fast ())
+  {
+    mp.type = MP_TYPE_DOUBLE;
+    mp.ucl.dbl = (double) value;
+    g_array_append_val (array, mp);
+    return;
+  }
+
   mp.type = MP_TYPE_REAL;
-  mode = mpfr_get_default_rounding_mode ();
-  mpfr_init_set_ld (mp.real, value, mode);
+  mode = ucl_context_get_rounding ();
+  mpfr_init2 (mp.real, ucl_context_get_precision ());
+  mpfr_set_ld (mp.real, value, mode);
   g_array_append_val (array, mp);
 }
 
@@ -402,9 +535,36 @@ _mp_stack_peek (MpStack* stack, int index)
   g_return_val_if_fail (stack != NULL, NULL);
   g_return_val_if_fail (index >= 0 && stack->length > index, NULL);
   MpValue* pmp = & stack->values [index];
+
+  /* callers expect GMP types, promote words in place */
+  if (pmp->type == MP_TYPE_WORD)
+    ucl_reg_cast ((UclReg*) pmp, (UclReg*) pmp, UCL_REG_TYPE_INTEGER);
 return (gpointer) & pmp->integer;
 }
 
+gpointer
+_mp_stack_reset_reg (MpStack* stack, int index)
+{
+  g_return_val_if_fail (stack != NULL, NULL);
+  g_return_val_if_fail (index >= 0 && stack->length > index, NULL);
+  MpValue* pmp = & stack->values [index];
+
+  if (pmp->type == MP_TYPE_VALUE)
+  {
+    _mp_stack_notify (pmp);
+    *pmp = __clean__;
+  }
+return (gpointer) pmp;
+}
+
+gpointer
+_mp_stack_peek_reg (MpStack* stack, int index)
+{
+  g_return_val_if_fail (stack != NULL, NULL);
+  g_return_val_if_fail (index >= 0 && stack->length > index, NULL);
+return (gpointer) & stack->values [index];
+}
+
 void
 _mp_stack_peek_value (MpStack* stack, int index, GValue* value)
 {
@@ -451,16 +611,22 @@ _mp_stack_peek_double (MpStack* stack, int index)
 
   switch (pmp->type)
   {
+  case MP_TYPE_WORD:
+    result = (double) pmp->ucl.word;
+    break;
   case MP_TYPE_INTEGER:
     result = mpz_get_d (pmp->integer);
     break;
   case MP_TYPE_RATIONAL:
     result = mpq_get_d (pmp->rational);
     break;
+  case MP_TYPE_DOUBLE:
+    result = pmp->ucl.dbl;
+    break;
   case MP_TYPE_REAL:
     {
       mpfr_rnd_t mode;
-      mode = mpfr_get_default_rounding_mode ();
+      mode = ucl_context_get_rounding ();
       result = mpfr_get_d (pmp->real, mode);
     }
     break;
@@ -482,10 +648,13 @@ _mp_stack_peek_ldouble (MpStack* stack, int index)
 
   switch (pmp->type)
   {
+  case MP_TYPE_DOUBLE:
+    result = pmp->ucl.dbl;
+    break;
   case MP_TYPE_REAL:
     {
       mpfr_rnd_t mode;
-      mode = mpfr_get_default_rounding_mode ();
+      mode = ucl_context_get_rounding ();
       result = mpfr_get_ld (pmp->real, mode);
     }
     break;
@@ -496,6 +665,72 @@ _mp_stack_peek_ldouble (MpStack* stack, int index)
 return result;
 }
 
+void
+_mp_stack_sweep (MpStack* stack)
+{
+  g_return_if_fail (stack != NULL);
+  MpValue* pmp = NULL;
+  guint i;
+
+  /* drops arbitrary values, numbers keep their storage */
+  for (i = 0; i < stack->length; i++)
+  {
+    pmp = & stack->values [i];
+    if (pmp->type == MP_TYPE_VALUE)
+    {
+      _mp_stack_notify (pmp);
+      *pmp = __clean__;
+    }
+  }
+}
+
+void
+_mp_stack_wipe (MpStack* stack)
+{
+  g_return_if_fail (stack != NULL);
+  MpValue* pmp = NULL;
+  guint i;
+
+  /* unlike sweep, numbers lose their storage too */
+  for (i = 0; i < stack->length; i++)
+  {
+    pmp = & stack->values [i];
+    _mp_stack_notify (pmp);
+    *pmp = __clean__;
+  }
+}
+
+void
+_mp_stack_rehome (MpStack* stack, int index)
+{
+  g_return_if_fail (stack != NULL);
+  g_return_if_fail (index >= 0 && stack->length > index);
+  MpValue* pmp = & stack->values [index];
+  MpValue tmp = __clean__;
+
+  /* deep copy through the current allocator, keeping precision */
+  switch (pmp->type)
+  {
+  case MP_TYPE_INTEGER:
+    mpz_init_set (tmp.integer, pmp->integer);
+    break;
+  case MP_TYPE_RATIONAL:
+    mpq_init (tmp.rational);
+    mpq_set (tmp.rational, pmp->rational);
+    break;
+  case MP_TYPE_REAL:
+    mpfr_init2 (tmp.real, mpfr_get_prec (pmp->real));
+    mpfr_set (tmp.real, pmp->real, MPFR_RNDN);
+    break;
+  default:
+    return;
+  }
+
+  tmp.type = pmp->type;
+  _mp_stack_notify (pmp);
+  *pmp = tmp;
+}
+
 void
 _mp_stack_pop (MpStack* stack, guint count)
 {
@@ -47,11 +47,19 @@ EXPORT const gchar*
 _mp_stack_type (MpStack* stack, int index);
 EXPORT void
 _mp_stack_transfer (MpStack* dst, MpStack* src);
+EXPORT void
+_mp_stack_steal (MpStack* dst, MpStack* src, int from, int count);
 EXPORT gboolean
 _mp_stack_cast (MpStack* stack, int index, const gchar* type);
 EXPORT void
 _mp_stack_push_index (MpStack* stack, int index);
 EXPORT void
+_mp_stack_copy (MpStack* stack, int index, MpStack* src, int from);
+EXPORT void
+_mp_stack_move (MpStack* stack, int index, MpStack* src, int from);
+EXPORT void
+_mp_stack_swap (MpStack* stack, int index1, int index2);
+EXPORT void
 _mp_stack_exchange (MpStack* stack, int index);
 EXPORT void
 _mp_stack_insert (MpStack* stack, int index);
@@ -67,6 +75,8 @@ EXPORT void
 _mp_stack_push_nil (MpStack* stack);
 EXPORT void
 _mp_stack_push_value (MpStack* stack, const GValue* value);
+EXPORT GValue*
+_mp_stack_reset_value (MpStack* stack, int index, GType type);
 EXPORT gboolean
 _mp_stack_push_string (MpStack* stack, const gchar* value, int base);
 EXPORT void
@@ -75,6 +85,10 @@ EXPORT void
 _mp_stack_push_ldouble (MpStack* stack, long double value);
 EXPORT gpointer
 _mp_stack_peek (MpStack* stack, int index);
+EXPORT gpointer
+_mp_stack_peek_reg (MpStack* stack, int index);
+EXPORT gpointer
+_mp_stack_reset_reg (MpStack* stack, int index);
 EXPORT void
 _mp_stack_peek_value (MpStack* stack, int index, GValue* value);
 EXPORT gchar*
@@ -84,6 +98,12 @@ _mp_stack_peek_double (MpStack* stack, int index);
 EXPORT long double
 _mp_stack_peek_ldouble (MpStack* stack, int index);
 EXPORT void
+_mp_stack_sweep (MpStack* stack);
+EXPORT void
+_mp_stack_wipe (MpStack* stack);
+EXPORT void
+_mp_stack_rehome (MpStack* stack, int index);
+EXPORT void
 _mp_stack_pop (MpStack* stack, guint count);
 
 #if __cplusplus
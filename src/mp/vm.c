@@ -38,10 +38,20 @@ struct _AbacoMP
   /*<private>*/
   AbacoAssembler* assembler;
   AbacoRules* rules;
+  AbacoCache* cache;
   GHashTable* constants;
   GHashTable* functions;
+  GHashTable* bindings;
+  GQueue lru;
   MpStack* stack;
+  GPtrArray* frames;
+  MpArena* arena;
+  UclContext context;
+  gsize id;
+  guint cepoch;
+  guint epoch;
   guint top;
+  guint threaded : 1;
 };
 
 struct _AbacoMPClass
@@ -53,11 +63,19 @@ enum
 {
   prop_0,
   prop_top,
+  prop_threaded,
+  prop_precision,
+  prop_rounding,
+  prop_fast,
+  prop_arena,
+  prop_parameterize,
+  prop_cache,
   prop_number,
 };
 
 static
 GParamSpec* properties [prop_number] = {0};
+static gsize last_id = 0;
 
 G_DEFINE_FINAL_TYPE_WITH_CODE
 (AbacoMP,
@@ -67,6 +85,10 @@ G_DEFINE_FINAL_TYPE_WITH_CODE
  (ABACO_TYPE_VM,
   abaco_mp_abaco_vm_iface));
 
+G_DEFINE_QUARK
+(abaco-mp-error-quark,
+ abaco_mp_error);
+
 /* private API */
 
 #define gettop() \
@@ -144,6 +166,85 @@ _abaco_mp_transfer_from (AbacoMP* self, MpStack* src)
   _mp_stack_transfer (self->stack, src);
 }
 
+gpointer
+_abaco_mp_peek_closure (AbacoMP* self, gint index)
+{
+  MpClosure* closure = NULL;
+  if ((index = validate_index (index)) < 0)
+    g_error ("Invalid index");
+  if (_mp_stack_type (self->stack, index) == MP_TYPE_VALUE)
+  {
+    GValue value = G_VALUE_INIT;
+    _mp_stack_peek_value (self->stack, index, &value);
+    if (G_VALUE_HOLDS (&value, _MP_TYPE_CLOSURE))
+      closure = _mp_value_get_closure (&value);
+    g_value_unset (&value);
+  }
+return closure;
+}
+
+UclReg*
+_abaco_mp_toreg (AbacoMP* self, gint index)
+{
+  if ((index = validate_index (index)) < 0)
+    g_error ("Invalid index");
+return _mp_stack_peek_reg (self->stack, index);
+}
+
+void
+_abaco_mp_steal_from (AbacoMP* self, MpStack* src, guint index, guint count)
+{
+  _mp_stack_steal (self->stack, src, index, count);
+}
+
+guint
+_abaco_mp_steal_frame (AbacoMP* self, MpStack* dst)
+{
+  guint i, top = gettop ();
+  for (i = 0; i < top; i++)
+    _mp_stack_move (dst, i, self->stack, self->top + i);
+  _mp_stack_pop (self->stack, top);
+return top;
+}
+
+/*
+ * Register files are pooled per VM (and as a VM
+ * is bound to a single thread, per thread too).
+ * Released frames keep their numeric registers
+ * so limbs get reused by the next execution.
+ *
+ */
+
+#define MAX_POOLED_FRAMES (16)
+
+MpStack*
+_abaco_mp_acquire_frame (AbacoMP* self, guint size)
+{
+  MpStack* stack = NULL;
+  guint length;
+
+  if (self->frames->len > 0)
+    stack = g_ptr_array_steal_index_fast (self->frames, self->frames->len - 1);
+  else
+    stack = _mp_stack_new ();
+
+  for (length = _mp_stack_get_length (stack); length < size; length++)
+    _mp_stack_push_nil (stack);
+return stack;
+}
+
+void
+_abaco_mp_release_frame (AbacoMP* self, MpStack* stack)
+{
+  if (self->frames->len >= MAX_POOLED_FRAMES)
+    _mp_stack_unref (stack);
+  else
+  {
+    _mp_stack_sweep (stack);
+    g_ptr_array_add (self->frames, stack);
+  }
+}
+
 const gchar*
 _abaco_mp_lookup_constant (AbacoMP* self, const gchar* key)
 {
@@ -168,6 +269,159 @@ _abaco_mp_lookup_function (AbacoMP* self, const gchar* key)
 return NULL;
 }
 
+gint
+_abaco_mp_call_frame (AbacoMP* self, MpStack* stack, guint func, guint base, guint count)
+{
+  guint oldtop = self->top;
+  guint length = _mp_stack_get_length (self->stack);
+  MpClosure* closure = NULL;
+  gint result;
+
+  /*
+   * Closure and arguments are moved (not copied) from
+   * caller registers into a fresh frame on top of the
+   * VM stack; R(func) receives the result, argument
+   * registers are left as nils
+   *
+   */
+
+  GValue value = G_VALUE_INIT;
+  _mp_stack_peek_value (stack, func, &value);
+  if (!G_VALUE_HOLDS (&value, _MP_TYPE_CLOSURE))
+    g_error ("Attempt to call a non-function value");
+
+  closure =
+  _mp_value_get_closure (&value);
+  _mp_closure_ref (closure);
+  g_value_unset (&value);
+
+  _mp_stack_steal (self->stack, stack, func, 1);
+  _mp_stack_steal (self->stack, stack, base, count);
+
+  self->top = length + 1;
+  result = _mp_closure_invoke (closure, self);
+
+  if (result > 0)
+  {
+    if (gettop () == 0)
+      g_error ("Closure returns value but stack is empty");
+    _mp_stack_transfer (stack, self->stack);
+    _mp_stack_exchange (stack, func);
+    _mp_stack_pop (stack, 1);
+  }
+
+  _mp_stack_pop (self->stack, _mp_stack_get_length (self->stack) - length);
+  _mp_closure_unref (closure);
+  self->top = oldtop;
+return result;
+}
+
+guint
+_abaco_mp_get_epoch (AbacoMP* self)
+{
+  return self->epoch;
+}
+
+guint
+_abaco_mp_get_constants_epoch (AbacoMP* self)
+{
+  return self->cepoch;
+}
+
+gsize
+_abaco_mp_get_id (AbacoMP* self)
+{
+  return self->id;
+}
+
+#define MAX_BINDINGS (64)
+
+MpBinding*
+_abaco_mp_get_binding (AbacoMP* self, MpProgram* program)
+{
+  MpBinding* binding = NULL;
+
+  /*
+   * Bindings for programs loaded by other VMs keep
+   * those programs alive, so they are capped; once
+   * full, the least recently used one not pinned by
+   * a running evaluation makes room for the new one
+   *
+   */
+
+  if ((binding = g_hash_table_lookup (self->bindings, program)) != NULL)
+  {
+    if (self->lru.head != &binding->link)
+    {
+      g_queue_unlink (&self->lru, &binding->link);
+      g_queue_push_head_link (&self->lru, &binding->link);
+    }
+  }
+  else
+  {
+    if (g_hash_table_size (self->bindings) >= MAX_BINDINGS)
+    {
+      GList* link = NULL;
+
+      for (link = self->lru.tail; link != NULL; link = link->prev)
+      if (((MpBinding*) g_hash_table_lookup (self->bindings, link->data))->pins == 0)
+      {
+        g_queue_unlink (&self->lru, link);
+        g_hash_table_remove (self->bindings, link->data);
+        break;
+      }
+    }
+
+    binding = g_slice_new0 (MpBinding);
+    binding->link.data = program;
+    g_hash_table_insert (self->bindings, _mp_program_ref (program), binding);
+    g_queue_push_head_link (&self->lru, &binding->link);
+  }
+return binding;
+}
+
+gboolean
+_abaco_mp_get_threaded (AbacoMP* self)
+{
+  return self->threaded;
+}
+
+const UclContext*
+_abaco_mp_enter (AbacoMP* self)
+{
+  return ucl_context_enter (&self->context);
+}
+
+MpArenaScope
+_abaco_mp_arena_enter (AbacoMP* self)
+{
+  return _mp_arena_enter (self->arena);
+}
+
+void
+_abaco_mp_arena_leave (AbacoMP* self, MpArenaScope scope, gboolean keep_top)
+{
+  guint i;
+
+  /*
+   * Closing the scope resets the arena, so the value
+   * handed back is copied to the heap first and pooled
+   * frames give their registers up
+   *
+   */
+
+  if (scope == MP_ARENA_SCOPE_OPENED)
+  {
+    _mp_arena_seal ();
+    if (keep_top)
+      _mp_stack_rehome (self->stack, _mp_stack_get_length (self->stack) - 1);
+    for (i = 0; i < self->frames->len; i++)
+      _mp_stack_wipe (g_ptr_array_index (self->frames, i));
+  }
+
+  _mp_arena_leave (scope);
+}
+
 /* Abaco.VM */
 
 static void
@@ -282,8 +536,25 @@ abaco_mp_abaco_vm_iface_pushcclosure (AbacoVM* pself, AbacoCClosure callback, gi
   if (upvalues > top)
     g_error ("Too much upvalues for closure");
 
-  MpClosure* closure =
+  MpArenaScope scope;
+  MpClosure* closure = NULL;
+  guint i, length = _mp_stack_get_length (self->stack);
+
+  /*
+   * Closures may outlive the evaluation which creates
+   * them, so upvalues are copied off the arena before
+   * they move into the closure
+   *
+   */
+
+  scope = _mp_arena_enter (NULL);
+  if (_mp_arena_active ())
+  for (i = 0; i < (guint) upvalues; i++)
+    _mp_stack_rehome (self->stack, length - i - 1);
+
+  closure =
   _mp_cclosure_new (self->stack, upvalues, callback);
+  _mp_arena_leave (scope);
 
   GValue value = G_VALUE_INIT;
   g_value_init (&value, _MP_TYPE_CCLOSURE);
@@ -292,6 +563,89 @@ abaco_mp_abaco_vm_iface_pushcclosure (AbacoVM* pself, AbacoCClosure callback, gi
   g_value_unset (&value);
 }
 
+static GBytes*
+_abaco_mp_assemble (AbacoMP* self, GBytes* bytes, GError** error)
+{
+  AbacoAstNode* tree = NULL;
+  GError* tmp_err = NULL;
+  GBytes* source = NULL;
+  GBytes* code = NULL;
+  GBytes* bound = NULL;
+  const gchar* input = NULL;
+  gchar** literals = NULL;
+  gint n_literals = 0;
+  gchar* key = NULL;
+  guint generation = 0;
+  gsize length = 0;
+
+  /*
+   * Only assembled code is cached: programs bind
+   * literals under the VM context in effect at load
+   * time, so they are rebuilt on every load. With
+   * parameterize set, code is cached as a template
+   * under the literal-free key of the expression and
+   * bound to this load's literal table.
+   *
+   */
+
+  input = g_bytes_get_data (bytes, &length);
+  generation = abaco_rules_get_generation (self->rules) << 2
+             | abaco_assembler_get_parameterize (self->assembler) << 1
+             | abaco_assembler_get_fuse (self->assembler);
+
+  if (abaco_assembler_get_parameterize (self->assembler)
+    && (key = abaco_rules_normalize (self->rules, input, length, &literals, &n_literals)) != NULL)
+    source = g_bytes_new_take (key, strlen (key));
+  else
+    source = g_bytes_ref (bytes);
+
+  if ((code = abaco_cache_lookup (self->cache, source, generation)) == NULL)
+  {
+    tree =
+    abaco_rules_parse (self->rules, input, length, &tmp_err);
+    if (G_UNLIKELY (tmp_err != NULL))
+    {
+      g_propagate_error (error, tmp_err);
+      _abaco_ast_node_unref0 (tree);
+      g_bytes_unref (source);
+      g_strfreev (literals);
+      return NULL;
+    }
+
+    if (literals == NULL)
+      code = abaco_assembler_assemble (self->assembler, tree, &tmp_err);
+    else
+      code = abaco_assembler_assemble_template (self->assembler, tree, literals, n_literals, &tmp_err);
+    _abaco_ast_node_unref0 (tree);
+    if (G_UNLIKELY (tmp_err != NULL))
+    {
+      g_propagate_error (error, tmp_err);
+      _g_bytes_unref0 (code);
+      g_bytes_unref (source);
+      g_strfreev (literals);
+      return NULL;
+    }
+
+    abaco_cache_insert (self->cache, source, generation, code, NULL);
+  }
+
+  g_bytes_unref (source);
+  if (literals == NULL)
+    return code;
+
+  bound =
+  abaco_assembler_bind (code, literals, n_literals, &tmp_err);
+  g_bytes_unref (code);
+  g_strfreev (literals);
+  if (G_UNLIKELY (tmp_err != NULL))
+  {
+    g_propagate_error (error, tmp_err);
+    _g_bytes_unref0 (bound);
+    return NULL;
+  }
+return bound;
+}
+
 static gboolean
 abaco_mp_abaco_vm_iface_loadbytes (AbacoVM* pself, GBytes* bytes, GError** error)
 {
@@ -299,6 +653,7 @@ abaco_mp_abaco_vm_iface_loadbytes (AbacoVM* pself, GBytes* bytes, GError** error
   const gchar* input = NULL;
   GValue value = G_VALUE_INIT;
   MpClosure* closure = NULL;
+  MpProgram* program = NULL;
   BHeader* header = NULL;
   gsize length = 0;
 
@@ -307,31 +662,28 @@ abaco_mp_abaco_vm_iface_loadbytes (AbacoVM* pself, GBytes* bytes, GError** error
 
   if (!b_header_check_magic (header))
   {
-    AbacoAstNode* tree = NULL;
     GError* tmp_err = NULL;
 
-    tree =
-    abaco_rules_parse (self->rules, input, length, &tmp_err);
+    bytes =
+    _abaco_mp_assemble (self, bytes, &tmp_err);
     if (G_UNLIKELY (tmp_err != NULL))
     {
       g_propagate_error (error, tmp_err);
-      _abaco_ast_node_unref0 (tree);
       return FALSE;
     }
 
-    bytes =
-    abaco_assembler_assemble (self->assembler, tree, &tmp_err);
-    _abaco_ast_node_unref0 (tree);
+    program =
+    _mp_program_new (self, bytes, &tmp_err);
+    g_bytes_unref (bytes);
     if (G_UNLIKELY (tmp_err != NULL))
     {
       g_propagate_error (error, tmp_err);
-      _g_bytes_unref0 (bytes);
       return FALSE;
     }
 
     closure =
-    _mp_function_new (bytes);
-    g_bytes_unref (bytes);
+    _mp_function_new (program);
+    _mp_program_unref (program);
 
     g_value_init (&value, _MP_TYPE_FUNCTION);
     _mp_value_take_closure (&value, closure);
@@ -342,17 +694,33 @@ abaco_mp_abaco_vm_iface_loadbytes (AbacoVM* pself, GBytes* bytes, GError** error
   {
     gpointer pheader = (gpointer) input;
     BHeader* header = (BHeader*) pheader;
+    GError* tmp_err = NULL;
     input += sizeof (BHeader);
     length -= sizeof (BHeader);
 
     uint32_t chke = header->checksum;
     uint32_t chkc = _bytecode_checksum (input, length);
     if (G_UNLIKELY (chke != chkc))
-      g_error ("Invalid program: bad checksum");
+    {
+      g_set_error
+      (error,
+       ABACO_MP_ERROR,
+       ABACO_MP_ERROR_INVALID_BINARY,
+       "Invalid program: bad checksum");
+      return FALSE;
+    }
 
-    bytes = g_bytes_new_static (input, length);
-    closure = _mp_function_new (bytes);
+    bytes = g_bytes_new_from_bytes (bytes, sizeof (BHeader), length);
+    program = _mp_program_new (self, bytes, &tmp_err);
     g_bytes_unref (bytes);
+    if (G_UNLIKELY (tmp_err != NULL))
+    {
+      g_propagate_error (error, tmp_err);
+      return FALSE;
+    }
+
+    closure = _mp_function_new (program);
+    _mp_program_unref (program);
 
     g_value_init (&value, _MP_TYPE_FUNCTION);
     _mp_value_take_closure (&value, closure);
@@ -374,6 +742,8 @@ abaco_mp_abaco_vm_iface_call (AbacoVM* pself, gint args)
     g_error ("Too much arguments for call");
   gint result, loc = validate_index (-(args + 1));
   guint oldtop = self->top;
+  const UclContext* last = NULL;
+  MpArenaScope scope;
   MpClosure* closure = NULL;
 
   GValue value = G_VALUE_INIT;
@@ -388,27 +758,40 @@ abaco_mp_abaco_vm_iface_call (AbacoVM* pself, gint args)
     g_value_unset (&value);
 
     self->top = _mp_stack_get_length (self->stack) - args;
+    last = ucl_context_enter (&self->context);
+    scope = _abaco_mp_arena_enter (self);
     result = _mp_closure_invoke (closure, self);
 
     if (result > 0)
     {
       if (gettop () == 0)
-    g_error ("Closure returns value but stack is empty");
-      abaco_vm_insert (pself, 0);
-      abaco_vm_settop (pself, 1);
+        g_error ("Closure returns value but stack is empty");
+      _mp_stack_exchange (self->stack, loc);
+      _mp_stack_pop (self->stack, _mp_stack_get_length (self->stack) - loc - 1);
     }
     else
     {
-      abaco_vm_settop (pself, 0);
+      _mp_stack_pop (self->stack, _mp_stack_get_length (self->stack) - loc);
     }
 
-    _mp_stack_remove (self->stack, loc);
+    _abaco_mp_arena_leave (self, scope, result > 0);
+    ucl_context_leave (last);
     _mp_closure_unref (closure);
     self->top = oldtop;
   }
 return result;
 }
 
+static inline void
+_abaco_mp_unfuse (AbacoMP* self, const gchar* expr)
+{
+  /* a user '+', '*' or 'fma' must see every call */
+  if (!g_strcmp0 (expr, "+")
+    || !g_strcmp0 (expr, "*")
+    || !g_strcmp0 (expr, "fma"))
+    abaco_assembler_set_fuse (self->assembler, FALSE);
+}
+
 static void
 abaco_mp_abaco_vm_iface_register_operator (AbacoVM* pself, const gchar* expr, gboolean assoc, gint precedence, gboolean unary)
 {
@@ -432,6 +815,8 @@ abaco_mp_abaco_vm_iface_register_operator (AbacoVM* pself, const gchar* expr, gb
 
     abaco_rules_add_operator (self->rules, expr, assoc, precedence, unary, &tmp_err);
     g_hash_table_insert (self->functions, g_strdup (expr), closure);
+    _abaco_mp_unfuse (self, expr);
+    ++self->epoch;
     if (G_UNLIKELY (tmp_err != NULL))
     {
       g_error
@@ -470,6 +855,8 @@ abaco_mp_abaco_vm_iface_register_function (AbacoVM* pself, const gchar* expr)
 
     abaco_rules_add_function (self->rules, expr, -1, &tmp_err);
     g_hash_table_insert (self->functions, g_strdup (expr), closure);
+    _abaco_mp_unfuse (self, expr);
+    ++self->epoch;
     if (G_UNLIKELY (tmp_err != NULL))
     {
       g_error
@@ -588,6 +975,31 @@ abaco_mp_class_set_property (GObject* pself, guint prop_id, const GValue* value,
   case prop_top:
     abaco_vm_settop (ABACO_VM (self), g_value_get_int (value));
     break;
+  case prop_threaded:
+    self->threaded = MP_THREADED_DISPATCH && g_value_get_boolean (value);
+    break;
+  case prop_precision:
+    self->context.precision = g_value_get_long (value);
+    ++self->cepoch;
+    break;
+  case prop_rounding:
+    self->context.rounding = g_value_get_int (value);
+    ++self->cepoch;
+    break;
+  case prop_fast:
+    self->context.fast = g_value_get_boolean (value);
+    ++self->cepoch;
+    break;
+  case prop_arena:
+    if (!g_value_get_boolean (value))
+      g_clear_pointer (&self->arena, _mp_arena_free);
+    else
+    if (self->arena == NULL)
+      self->arena = _mp_arena_new ();
+    break;
+  case prop_parameterize:
+    abaco_assembler_set_parameterize (self->assembler, g_value_get_boolean (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (pself, prop_id, pspec);
     break;
@@ -603,6 +1015,27 @@ abaco_mp_class_get_property (GObject* pself, guint prop_id, GValue* value, GPara
   case prop_top:
     g_value_set_int (value, abaco_vm_gettop (ABACO_VM (self)));
     break;
+  case prop_threaded:
+    g_value_set_boolean (value, self->threaded);
+    break;
+  case prop_precision:
+    g_value_set_long (value, self->context.precision);
+    break;
+  case prop_rounding:
+    g_value_set_int (value, self->context.rounding);
+    break;
+  case prop_fast:
+    g_value_set_boolean (value, self->context.fast);
+    break;
+  case prop_arena:
+    g_value_set_boolean (value, self->arena != NULL);
+    break;
+  case prop_parameterize:
+    g_value_set_boolean (value, abaco_assembler_get_parameterize (self->assembler));
+    break;
+  case prop_cache:
+    g_value_set_object (value, self->cache);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (pself, prop_id, pspec);
     break;
@@ -614,8 +1047,11 @@ abaco_mp_class_finalize (GObject* pself)
 {
   AbacoMP* self = ABACO_MP (pself);
   _mp_stack_unref (self->stack);
+  g_ptr_array_unref (self->frames);
+  g_clear_pointer (&self->arena, _mp_arena_free);
   g_hash_table_unref (self->constants);
   g_hash_table_unref (self->functions);
+  g_hash_table_unref (self->bindings);
 G_OBJECT_CLASS (abaco_mp_parent_class)->finalize (pself);
 }
 
@@ -625,8 +1061,12 @@ abaco_mp_class_dispose (GObject* pself)
   AbacoMP* self = ABACO_MP (pself);
   _g_object_unref0 (self->assembler);
   _g_object_unref0 (self->rules);
+  _g_object_unref0 (self->cache);
   g_hash_table_remove_all (self->constants);
   g_hash_table_remove_all (self->functions);
+  ++self->cepoch;
+  g_hash_table_remove_all (self->bindings);
+  g_queue_init (&self->lru);
 G_OBJECT_CLASS (abaco_mp_parent_class)->dispose (pself);
 }
 
@@ -635,6 +1075,7 @@ abaco_mp_class_init (AbacoMPClass* klass)
 {
   GObjectClass* oclass = G_OBJECT_CLASS (klass);
   GParamFlags flags1 = G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS;
+  GParamFlags flags2 = G_PARAM_READABLE | G_PARAM_STATIC_STRINGS;
 
   oclass->set_property = abaco_mp_class_set_property;
   oclass->get_property = abaco_mp_class_get_property;
@@ -642,6 +1083,13 @@ abaco_mp_class_init (AbacoMPClass* klass)
   oclass->dispose = abaco_mp_class_dispose;
 
   properties [prop_top] = g_param_spec_int ("top", "top", "top", 0, G_MAXINT, 0, flags1);
+  properties [prop_threaded] = g_param_spec_boolean ("threaded", "threaded", "threaded", MP_THREADED_DISPATCH, flags1);
+  properties [prop_precision] = g_param_spec_long ("precision", "precision", "precision", MPFR_PREC_MIN, MPFR_PREC_MAX, 53, flags1);
+  properties [prop_rounding] = g_param_spec_int ("rounding", "rounding", "rounding", MPFR_RNDN, MPFR_RNDA, MPFR_RNDN, flags1);
+  properties [prop_fast] = g_param_spec_boolean ("fast", "fast", "fast", FALSE, flags1);
+  properties [prop_arena] = g_param_spec_boolean ("arena", "arena", "arena", FALSE, flags1);
+  properties [prop_parameterize] = g_param_spec_boolean ("parameterize", "parameterize", "parameterize", FALSE, flags1);
+  properties [prop_cache] = g_param_spec_object ("cache", "cache", "cache", ABACO_TYPE_CACHE, flags2);
   g_object_class_install_properties (G_OBJECT_CLASS (klass), prop_number, properties);
 }
 
@@ -650,9 +1098,18 @@ abaco_mp_init (AbacoMP* self)
 {
   self->assembler = abaco_assembler_new ();
   self->rules = abaco_rules_new ();
+  self->cache = abaco_cache_new ();
   self->constants = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
   self->functions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _mp_closure_unref);
+  self->bindings = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) _mp_program_unref, (GDestroyNotify) _mp_binding_free);
+  g_queue_init (&self->lru);
   self->stack = _mp_stack_new ();
+  self->frames = g_ptr_array_new_with_free_func (_mp_stack_unref);
+  self->id = (gsize) g_atomic_pointer_add (&last_id, 1) + 1;
+  self->cepoch = 1;
+  self->epoch = 1;
+  self->threaded = MP_THREADED_DISPATCH;
+  ucl_context_init (&self->context);
 }
 
 /* API */
@@ -673,6 +1130,13 @@ abaco_mp_new_naked ()
   g_object_new (ABACO_TYPE_MP, NULL);
 }
 
+AbacoCache*
+abaco_mp_get_cache (AbacoMP* self)
+{
+  g_return_val_if_fail (ABACO_IS_MP (self), NULL);
+return self->cache;
+}
+
 void
 abaco_mp_load_stdlib (AbacoMP* self)
 {
@@ -707,11 +1171,17 @@ abaco_mp_load_stdlib (AbacoMP* self)
     g_assert_no_error (tmp_err);
   closure = _mp_cclosure_new (NULL, 0, abaco_mp_power_pow);
   g_hash_table_insert (reg, g_strdup ("^"), closure);
+  ++self->epoch;
 
   abaco_vm_pushcclosure (vm, abaco_mp_power_sqrt, 0);
   abaco_vm_register_function (vm, "sqrt");
   abaco_vm_pushcclosure (vm, abaco_mp_power_cbrt, 0);
   abaco_vm_register_function (vm, "cbrt");
+  abaco_vm_pushcclosure (vm, abaco_mp_power_rootn, 0);
+  abaco_vm_register_function (vm, "rootn");
+  abaco_vm_pushcclosure (vm, abaco_mp_arith_fma, 0);
+  abaco_vm_register_function (vm, "fma");
+  abaco_assembler_set_fuse (self->assembler, TRUE);
 }
 
 #undef catch
@@ -733,22 +1203,30 @@ abaco_mp_cast (AbacoMP* self, gint index, const gchar* type)
                       || type == MP_TYPE_VALUE
                       || type == MP_TYPE_INTEGER
                       || type == MP_TYPE_RATIONAL
+                      || type == MP_TYPE_DOUBLE
                       || type == MP_TYPE_REAL, FALSE);
-return _mp_stack_cast (self->stack, index, type);
+  const UclContext* last = ucl_context_enter (&self->context);
+  gboolean success = _mp_stack_cast (self->stack, index, type);
+  ucl_context_leave (last);
+return success;
 }
 
 void
 abaco_mp_pushdouble (AbacoMP* self, double value)
 {
   g_return_if_fail (ABACO_IS_MP (self));
+  const UclContext* last = ucl_context_enter (&self->context);
   _mp_stack_push_double (self->stack, value);
+  ucl_context_leave (last);
 }
 
 void
 abaco_mp_pushldouble (AbacoMP* self, long double value)
 {
   g_return_if_fail (ABACO_IS_MP (self));
-  _mp_stack_push_double (self->stack, value);
+  const UclContext* last = ucl_context_enter (&self->context);
+  _mp_stack_push_ldouble (self->stack, value);
+  ucl_context_leave (last);
 }
 
 gboolean
@@ -756,7 +1234,10 @@ abaco_mp_pushstring (AbacoMP* self, const gchar* value, int base)
 {
   g_return_val_if_fail (ABACO_IS_MP (self), FALSE);
   g_return_val_if_fail (value != NULL, FALSE);
-  _mp_stack_push_string (self->stack, value, base);
+  const UclContext* last = ucl_context_enter (&self->context);
+  gboolean success = _mp_stack_push_string (self->stack, value, base);
+  ucl_context_leave (last);
+return success;
 }
 
 double
@@ -783,6 +1264,16 @@ abaco_mp_tostring (AbacoMP* self, gint index, int base)
 return _mp_stack_peek_string (self->stack, index, base);
 }
 
+gsize
+abaco_mp_tobuffer (AbacoMP* self, gint index, GString* buffer, int base)
+{
+  g_return_val_if_fail (ABACO_IS_MP (self), 0);
+  g_return_val_if_fail ((index = validate_index (index)) >= 0, 0);
+  g_return_val_if_fail (buffer != NULL, 0);
+  g_return_val_if_fail (base != 0, 0);
+return ucl_reg_format_append (_mp_stack_peek_reg (self->stack, index), buffer, base, UCL_FORMAT_EXACT, 0);
+}
+
 mpz_ptr
 abaco_mp_tointeger (AbacoMP* self, gint index)
 {
@@ -16,6 +16,9 @@
  *
  */
 #include <config.h>
+#include <math.h>
+#include <context.h>
+#include <kernel.h>
 #include <libabaco_ucl.h>
 
 #define fresh(reg, _type) \
@@ -25,209 +28,902 @@
     __reg->type = (_type); \
   } G_STMT_END
 
-#define round (mpfr_get_default_rounding_mode ())
+G_STATIC_ASSERT (sizeof (glong) <= sizeof (mp_limb_t));
 
-#define simple(suffix) \
-void \
-ucl_arithmetic_##suffix (UclReg* accum, const UclReg* next) \
+/*
+ * Gives a machine word a read-only mpz face backed
+ * by 'limb', so word operands can be fed to GMP
+ * without allocating
+ *
+ */
+
+static inline const UclReg*
+_word_view (UclReg* view, mp_limb_t* limb, glong word)
+{
+  *limb = (word < 0) ? - (mp_limb_t) word : (mp_limb_t) word;
+  mpz_roinit_n (view->integer, limb, (word < 0) ? -1 : (word > 0));
+  view->type = UCL_REG_TYPE_INTEGER;
+return view;
+}
+
+/*
+ * Double accumulators absorb any exact operand;
+ * native kernels are plain hardware arithmetic
+ *
+ */
+
+static inline gdouble
+_as_double (const UclReg* reg)
+{
+  switch (reg->type)
+  {
+  case UCL_REG_TYPE_WORD:
+    return (gdouble) reg->word;
+  case UCL_REG_TYPE_INTEGER:
+    return mpz_get_d (reg->integer);
+  case UCL_REG_TYPE_RATIONAL:
+    return mpq_get_d (reg->rational);
+  default:
+    return reg->dbl;
+  }
+}
+
+static inline gdouble _d_add (gdouble a, gdouble b) { return a + b; }
+static inline gdouble _d_sub (gdouble a, gdouble b) { return a - b; }
+static inline gdouble _d_mul (gdouble a, gdouble b) { return a * b; }
+static inline gdouble _d_div (gdouble a, gdouble b) { return a / b; }
+
+/*
+ * Mixed integer/rational kernels; with q = n/d in
+ * lowest terms, q + z = (n + zd)/d is still in lowest
+ * terms, so only products need canonicalization
+ *
+ */
+
+static inline void
+_qz_add (mpq_ptr q, mpz_srcptr z)
+{
+  mpz_addmul (mpq_numref (q), mpq_denref (q), z);
+}
+
+static inline void
+_qz_sub (mpq_ptr q, mpz_srcptr z)
+{
+  mpz_submul (mpq_numref (q), mpq_denref (q), z);
+}
+
+static inline void
+_qz_mul (mpq_ptr q, mpz_srcptr z)
+{
+  mpz_mul (mpq_numref (q), mpq_numref (q), z);
+  mpq_canonicalize (q);
+}
+
+/*
+ * An integer accumulator turns rational in place: its
+ * mpz already sits where the numerator goes, so only
+ * the denominator needs initialization
+ *
+ */
+
+G_STATIC_ASSERT (G_STRUCT_OFFSET (__mpq_struct, _mp_num) == 0);
+
+static inline mpq_ptr
+_zq_promote (UclReg* accum, mpq_srcptr q)
+{
+  mpz_init_set (mpq_denref (accum->rational), mpq_denref (q));
+  accum->type = UCL_REG_TYPE_RATIONAL;
+return accum->rational;
+}
+
+static inline void
+_zq_add (UclReg* accum, mpq_srcptr q)
+{
+  mpq_ptr r = _zq_promote (accum, q);
+  mpz_mul (mpq_numref (r), mpq_numref (r), mpq_denref (q));
+  mpz_add (mpq_numref (r), mpq_numref (r), mpq_numref (q));
+}
+
+static inline void
+_zq_sub (UclReg* accum, mpq_srcptr q)
+{
+  mpq_ptr r = _zq_promote (accum, q);
+  mpz_mul (mpq_numref (r), mpq_numref (r), mpq_denref (q));
+  mpz_sub (mpq_numref (r), mpq_numref (r), mpq_numref (q));
+}
+
+static inline void
+_zq_mul (UclReg* accum, mpq_srcptr q)
+{
+  mpq_ptr r = _zq_promote (accum, q);
+  mpz_mul (mpq_numref (r), mpq_numref (r), mpq_numref (q));
+  mpq_canonicalize (r);
+}
+
+static inline void
+_z_add_si (mpz_ptr z, glong word)
+{
+  if (word >= 0)
+    mpz_add_ui (z, z, (gulong) word);
+  else
+    mpz_sub_ui (z, z, - (gulong) word);
+}
+
+static inline void
+_z_sub_si (mpz_ptr z, glong word)
+{
+  if (word >= 0)
+    mpz_sub_ui (z, z, (gulong) word);
+  else
+    mpz_add_ui (z, z, - (gulong) word);
+}
+
+static inline void
+_z_mul_si (mpz_ptr z, glong word)
+{
+  mpz_mul_si (z, z, word);
+}
+
+/*
+ * Scalar kernels, one per accumulator/operand type
+ * pair (w, z, q, d and r for word, integer, rational,
+ * double and real, x for any narrower type); void
+ * accumulators just take a copy of the operand
+ *
+ */
+
+void
+_ucl_kernel_invalid (UclReg* accum, const UclReg* next)
+{
+  g_error ("Should be a numeric value");
+  g_assert_not_reached ();
+}
+
+void
+_ucl_kernel_load_word (UclReg* accum, const UclReg* next)
+{
+  fresh (accum, UCL_REG_TYPE_WORD);
+  accum->word = next->word;
+}
+
+void
+_ucl_kernel_load_integer (UclReg* accum, const UclReg* next)
+{
+  fresh (accum, UCL_REG_TYPE_INTEGER);
+  mpz_init_set (accum->integer, next->integer);
+}
+
+void
+_ucl_kernel_load_rational (UclReg* accum, const UclReg* next)
+{
+  fresh (accum, UCL_REG_TYPE_RATIONAL);
+  mpq_init (accum->rational);
+  mpq_set (accum->rational, next->rational);
+}
+
+void
+_ucl_kernel_load_double (UclReg* accum, const UclReg* next)
+{
+  fresh (accum, UCL_REG_TYPE_DOUBLE);
+  accum->dbl = next->dbl;
+}
+
+void
+_ucl_kernel_load_real (UclReg* accum, const UclReg* next)
+{
+  fresh (accum, UCL_REG_TYPE_REAL);
+  _ucl_mpfr_init (accum->real);
+  mpfr_set (accum->real, next->real, round);
+}
+
+#define kernels(suffix) \
+static void \
+_##suffix##_ww (UclReg* accum, const UclReg* next) \
 { \
-  if (accum->type == UCL_REG_TYPE_VOID) \
+  glong word; \
+  if (!__builtin_##suffix##_overflow (accum->word, next->word, &word)) \
+    accum->word = word; \
+  else \
   { \
-    switch (next->type) \
-    { \
-    case UCL_REG_TYPE_INTEGER: \
-      fresh (accum, next->type); \
-      mpz_init (accum->integer); \
-      mpz_set (accum->integer, next->integer); \
-      break; \
-    case UCL_REG_TYPE_RATIONAL: \
-      fresh (accum, next->type); \
-      mpq_init (accum->rational); \
-      mpq_set (accum->rational, next->rational); \
-      break; \
-    case UCL_REG_TYPE_REAL: \
-      fresh (accum, next->type); \
-      mpfr_init (accum->real); \
-      mpfr_set (accum->real, next->real, round); \
-      break; \
-    default: \
-      g_error ("Should be a numeric value"); \
-      g_assert_not_reached (); \
-      break; \
-    } \
+    ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER); \
+    _z_##suffix##_si (accum->integer, next->word); \
   } \
-  else \
+} \
+ \
+static void \
+_##suffix##_zw (UclReg* accum, const UclReg* next) \
+{ \
+  _z_##suffix##_si (accum->integer, next->word); \
+} \
+ \
+static void \
+_##suffix##_zz (UclReg* accum, const UclReg* next) \
+{ \
+  mpz_##suffix (accum->integer, accum->integer, next->integer); \
+} \
+ \
+static void \
+_##suffix##_zq (UclReg* accum, const UclReg* next) \
+{ \
+  _zq_##suffix (accum, next->rational); \
+} \
+ \
+static void \
+_##suffix##_wz (UclReg* accum, const UclReg* next) \
+{ \
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER); \
+  _##suffix##_zz (accum, next); \
+} \
+ \
+static void \
+_##suffix##_wq (UclReg* accum, const UclReg* next) \
+{ \
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER); \
+  _##suffix##_zq (accum, next); \
+} \
+ \
+static void \
+_##suffix##_qw (UclReg* accum, const UclReg* next) \
+{ \
+  UclReg view; \
+  mp_limb_t limb; \
+  _qz_##suffix (accum->rational, _word_view (&view, &limb, next->word)->integer); \
+} \
+ \
+static void \
+_##suffix##_qz (UclReg* accum, const UclReg* next) \
+{ \
+  _qz_##suffix (accum->rational, next->integer); \
+} \
+ \
+static void \
+_##suffix##_qq (UclReg* accum, const UclReg* next) \
+{ \
+  mpq_##suffix (accum->rational, accum->rational, next->rational); \
+} \
+ \
+static void \
+_##suffix##_dx (UclReg* accum, const UclReg* next) \
+{ \
+  accum->dbl = _d_##suffix (accum->dbl, _as_double (next)); \
+} \
+ \
+static void \
+_##suffix##_dd (UclReg* accum, const UclReg* next) \
+{ \
+  accum->dbl = _d_##suffix (accum->dbl, next->dbl); \
+} \
+ \
+static void \
+_##suffix##_xd (UclReg* accum, const UclReg* next) \
+{ \
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_DOUBLE); \
+  _##suffix##_dd (accum, next); \
+} \
+ \
+static void \
+_##suffix##_rw (UclReg* accum, const UclReg* next) \
+{ \
+  mpfr_##suffix##_si (accum->real, accum->real, next->word, round); \
+} \
+ \
+static void \
+_##suffix##_rz (UclReg* accum, const UclReg* next) \
+{ \
+  mpfr_##suffix##_z (accum->real, accum->real, next->integer, round); \
+} \
+ \
+static void \
+_##suffix##_rq (UclReg* accum, const UclReg* next) \
+{ \
+  mpfr_##suffix##_q (accum->real, accum->real, next->rational, round); \
+} \
+ \
+static void \
+_##suffix##_rd (UclReg* accum, const UclReg* next) \
+{ \
+  mpfr_##suffix##_d (accum->real, accum->real, next->dbl, round); \
+} \
+ \
+static void \
+_##suffix##_rr (UclReg* accum, const UclReg* next) \
+{ \
+  mpfr_##suffix (accum->real, accum->real, next->real, round); \
+} \
+ \
+static void \
+_##suffix##_xr (UclReg* accum, const UclReg* next) \
+{ \
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL); \
+  _##suffix##_rr (accum, next); \
+} \
+ \
+static const UclKernelTable _kernels_##suffix = \
+{ \
+  UCL_KERNELS_LOAD, \
+  UCL_KERNELS_INVALID, \
   { \
-    if (next->type < UCL_REG_TYPE_INTEGER \
-      || next->type > UCL_REG_TYPE_REAL) \
-    { \
-      g_error ("Should be a numeric value"); \
-      g_assert_not_reached (); \
-    } \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _##suffix##_ww, \
+    _##suffix##_wz, \
+    _##suffix##_wq, \
+    _##suffix##_xd, \
+    _##suffix##_xr, \
+  }, \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _##suffix##_zw, \
+    _##suffix##_zz, \
+    _##suffix##_zq, \
+    _##suffix##_xd, \
+    _##suffix##_xr, \
+  }, \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _##suffix##_qw, \
+    _##suffix##_qz, \
+    _##suffix##_qq, \
+    _##suffix##_xd, \
+    _##suffix##_xr, \
+  }, \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _##suffix##_dx, \
+    _##suffix##_dx, \
+    _##suffix##_dx, \
+    _##suffix##_dd, \
+    _##suffix##_xr, \
+  }, \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _##suffix##_rw, \
+    _##suffix##_rz, \
+    _##suffix##_rq, \
+    _##suffix##_rd, \
+    _##suffix##_rr, \
+  }, \
+}; \
+ \
+void \
+ucl_arithmetic_##suffix (UclReg* accum, const UclReg* next) \
+{ \
+  _kernels_##suffix [accum->type] [next->type] (accum, next); \
+}
+
+kernels (add);
+kernels (sub);
+kernels (mul);
+
+/*
+ * Quotients are rational, so exact accumulators
+ * turn rational before dividing (even by words)
+ *
+ */
+
+static void
+_div_qw (UclReg* accum, const UclReg* next)
+{
+  mpz_ptr z = mpq_denref (accum->rational);
+  mpz_mul_si (z, z, next->word);
+  mpq_canonicalize (accum->rational);
+}
+
+static void
+_div_qz (UclReg* accum, const UclReg* next)
+{
+  mpz_ptr z = mpq_denref (accum->rational);
+  mpz_mul (z, z, next->integer);
+  mpq_canonicalize (accum->rational);
+}
+
+static void
+_div_qq (UclReg* accum, const UclReg* next)
+{
+  mpq_div (accum->rational, accum->rational, next->rational);
+}
+
+static void
+_div_xw (UclReg* accum, const UclReg* next)
+{
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_RATIONAL);
+  _div_qw (accum, next);
+}
+
+static void
+_div_xz (UclReg* accum, const UclReg* next)
+{
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_RATIONAL);
+  _div_qz (accum, next);
+}
+
+static void
+_div_xq (UclReg* accum, const UclReg* next)
+{
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_RATIONAL);
+  _div_qq (accum, next);
+}
+
+static void
+_div_dx (UclReg* accum, const UclReg* next)
+{
+  accum->dbl = _d_div (accum->dbl, _as_double (next));
+}
+
+static void
+_div_dd (UclReg* accum, const UclReg* next)
+{
+  accum->dbl = _d_div (accum->dbl, next->dbl);
+}
+
+static void
+_div_xd (UclReg* accum, const UclReg* next)
+{
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_DOUBLE);
+  _div_dd (accum, next);
+}
+
+static void
+_div_rw (UclReg* accum, const UclReg* next)
+{
+  mpfr_div_si (accum->real, accum->real, next->word, round);
+}
+
+static void
+_div_rz (UclReg* accum, const UclReg* next)
+{
+  mpfr_div_z (accum->real, accum->real, next->integer, round);
+}
+
+static void
+_div_rq (UclReg* accum, const UclReg* next)
+{
+  mpfr_div_q (accum->real, accum->real, next->rational, round);
+}
+
+static void
+_div_rd (UclReg* accum, const UclReg* next)
+{
+  mpfr_div_d (accum->real, accum->real, next->dbl, round);
+}
+
+static void
+_div_rr (UclReg* accum, const UclReg* next)
+{
+  mpfr_div (accum->real, accum->real, next->real, round);
+}
+
+static void
+_div_xr (UclReg* accum, const UclReg* next)
+{
+  ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
+  _div_rr (accum, next);
+}
+
+static const UclKernelTable _kernels_div =
+{
+  UCL_KERNELS_LOAD,
+  UCL_KERNELS_INVALID,
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _div_xw,
+    _div_xz,
+    _div_xq,
+    _div_xd,
+    _div_xr,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _div_xw,
+    _div_xz,
+    _div_xq,
+    _div_xd,
+    _div_xr,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _div_qw,
+    _div_qz,
+    _div_qq,
+    _div_xd,
+    _div_xr,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _div_dx,
+    _div_dx,
+    _div_dx,
+    _div_dd,
+    _div_xr,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _div_rw,
+    _div_rz,
+    _div_rq,
+    _div_rd,
+    _div_rr,
+  },
+};
+
+void
+ucl_arithmetic_div (UclReg* accum, const UclReg* next)
+{
+  _kernels_div [accum->type] [next->type] (accum, next);
+}
+
+static const UclKernelTable* const _kernels [] =
+{
+  [UCL_OPERATOR_ADD] = &_kernels_add,
+  [UCL_OPERATOR_SUB] = &_kernels_sub,
+  [UCL_OPERATOR_MUL] = &_kernels_mul,
+  [UCL_OPERATOR_DIV] = &_kernels_div,
+  [UCL_OPERATOR_POW] = &_ucl_kernels_pow,
+};
+
+UclKernel
+ucl_arithmetic_kernel (UclOperator op, UclRegType accum, UclRegType next)
+{
+  g_return_val_if_fail ((guint) op < G_N_ELEMENTS (_kernels), NULL);
+  g_return_val_if_fail ((guint) accum < UCL_N_TYPES, NULL);
+  g_return_val_if_fail ((guint) next < UCL_N_TYPES, NULL);
+  UclKernel kernel = (*_kernels [op]) [accum] [next];
+return (kernel != _ucl_kernel_invalid) ? kernel : NULL;
+}
+
+/*
+ * Array kernels fold 'nexts' into 'accum' left to
+ * right, with the same result as one scalar call per
+ * operand; types are dispatched once per homogeneous
+ * run, and whatever breaks a run takes the scalar path
+ *
+ */
+
+#define vector(suffix) \
+void \
+ucl_arithmetic_##suffix##_n (UclReg* accum, const UclReg* nexts, guint n_nexts) \
+{ \
+  const mpfr_rnd_t rnd = round; \
+  UclReg view; \
+  mp_limb_t limb; \
+  guint i = 0; \
  ; \
-    if (accum->type >= next->type) \
+  while (i < n_nexts) \
+  { \
+    switch (accum->type) \
     { \
-      switch (accum->type) \
+    case UCL_REG_TYPE_WORD: \
       { \
-      case UCL_REG_TYPE_INTEGER: \
-        switch (next->type) \
+        glong word = accum->word, tmp; \
+        for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_WORD; i++) \
         { \
-        case UCL_REG_TYPE_INTEGER: \
-          mpz_##suffix (accum->integer, accum->integer, next->integer); \
-          break; \
-        case UCL_REG_TYPE_RATIONAL: \
-          { \
-            mpz_t z; \
-            mpz_init (z); \
-            mpz_set_q (z, next->rational); \
-            mpz_##suffix (accum->integer, accum->integer, z); \
-            mpz_clear (z); \
-          } \
-          break; \
-        case UCL_REG_TYPE_REAL: \
-          { \
-            mpz_t z; \
-            mpz_init (z); \
-            mpfr_get_z (z, next->real, round); \
-            mpz_##suffix (accum->integer, accum->integer, z); \
-            mpz_clear (z); \
-          } \
-          break; \
-        } \
-        break; \
-      case UCL_REG_TYPE_RATIONAL: \
-        switch (next->type) \
-        { \
-        case UCL_REG_TYPE_RATIONAL: \
-          mpq_##suffix (accum->rational, accum->rational, next->rational); \
-          break; \
-        case UCL_REG_TYPE_INTEGER: \
-          { \
-            mpq_t q; \
-            mpq_init (q); \
-            mpq_set_z (q, next->integer); \
-            mpq_##suffix (accum->rational, accum->rational, q); \
-            mpq_clear (q); \
-          } \
-          break; \
-        case UCL_REG_TYPE_REAL: \
-          { \
-            mpq_t q; \
-            mpq_init (q); \
-            mpfr_get_q (q, next->real); \
-            mpq_##suffix (accum->rational, accum->rational, q); \
-            mpq_clear (q); \
-          } \
-          break; \
+          if (__builtin_##suffix##_overflow (word, nexts [i].word, &tmp)) \
+            break; \
+          word = tmp; \
         } \
-        break; \
-      case UCL_REG_TYPE_REAL: \
-        switch (next->type) \
-        { \
-        case UCL_REG_TYPE_INTEGER: \
-          mpfr_##suffix##_z (accum->real, accum->real, next->integer, round); \
-          break; \
-        case UCL_REG_TYPE_RATIONAL: \
-          mpfr_##suffix##_q (accum->real, accum->real, next->rational, round); \
+        accum->word = word; \
+      } \
+      break; \
+    case UCL_REG_TYPE_INTEGER: \
+      for (; i < n_nexts; i++) \
+      { \
+        if (nexts [i].type == UCL_REG_TYPE_WORD) \
+          _z_##suffix##_si (accum->integer, nexts [i].word); \
+        else \
+        if (nexts [i].type == UCL_REG_TYPE_INTEGER) \
+          mpz_##suffix (accum->integer, accum->integer, nexts [i].integer); \
+        else \
           break; \
-        case UCL_REG_TYPE_REAL: \
-          mpfr_##suffix (accum->real, accum->real, next->real, round); \
+      } \
+      break; \
+    case UCL_REG_TYPE_RATIONAL: \
+      for (; i < n_nexts; i++) \
+      { \
+        if (nexts [i].type == UCL_REG_TYPE_WORD) \
+          _qz_##suffix (accum->rational, _word_view (&view, &limb, nexts [i].word)->integer); \
+        else \
+        if (nexts [i].type == UCL_REG_TYPE_INTEGER) \
+          _qz_##suffix (accum->rational, nexts [i].integer); \
+        else \
+        if (nexts [i].type == UCL_REG_TYPE_RATIONAL) \
+          mpq_##suffix (accum->rational, accum->rational, nexts [i].rational); \
+        else \
           break; \
-        } \
-        break; \
       } \
+      break; \
+    case UCL_REG_TYPE_DOUBLE: \
+      { \
+        gdouble dbl = accum->dbl; \
+        for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_DOUBLE; i++) \
+          dbl = _d_##suffix (dbl, nexts [i].dbl); \
+        accum->dbl = dbl; \
+      } \
+      break; \
+    case UCL_REG_TYPE_REAL: \
+      for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_REAL; i++) \
+        mpfr_##suffix (accum->real, accum->real, nexts [i].real, rnd); \
+      break; \
     } \
-    else \
-    { \
-      ucl_reg_cast (accum, accum, next->type); \
-      ucl_arithmetic_##suffix (accum, next); \
-    } \
+ ; \
+    if (i < n_nexts) \
+      ucl_arithmetic_##suffix (accum, & nexts [i++]); \
   } \
 }
 
-simple (add);
-simple (sub);
-simple (mul);
+vector (add);
+vector (sub);
+vector (mul);
 
 void
-ucl_arithmetic_div (UclReg* accum, const UclReg* next)
+ucl_arithmetic_div_n (UclReg* accum, const UclReg* nexts, guint n_nexts)
 {
-  if (accum->type == UCL_REG_TYPE_VOID)
+  const mpfr_rnd_t rnd = round;
+  guint i = 0;
+
+  while (i < n_nexts)
   {
-    switch (next->type)
+    switch (accum->type)
     {
-    case UCL_REG_TYPE_INTEGER:
-      fresh (accum, next->type);
-      mpz_init (accum->integer);
-      mpz_set (accum->integer, next->integer);
-      break;
     case UCL_REG_TYPE_RATIONAL:
-      fresh (accum, next->type);
-      mpq_init (accum->rational);
-      mpq_set (accum->rational, next->rational);
+      {
+        mpz_ptr den = mpq_denref (accum->rational);
+        guint first = i;
+
+        /* canonical form is unique, so reduce once per run */
+        for (; i < n_nexts; i++)
+        {
+          if (nexts [i].type == UCL_REG_TYPE_WORD)
+            mpz_mul_si (den, den, nexts [i].word);
+          else
+          if (nexts [i].type == UCL_REG_TYPE_INTEGER)
+            mpz_mul (den, den, nexts [i].integer);
+          else
+            break;
+        }
+
+        if (i > first)
+          mpq_canonicalize (accum->rational);
+        for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_RATIONAL; i++)
+          mpq_div (accum->rational, accum->rational, nexts [i].rational);
+      }
       break;
-    case UCL_REG_TYPE_REAL:
-      fresh (accum, next->type);
-      mpfr_init (accum->real);
-      mpfr_set (accum->real, next->real, round);
+    case UCL_REG_TYPE_DOUBLE:
+      {
+        gdouble dbl = accum->dbl;
+        for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_DOUBLE; i++)
+          dbl = _d_div (dbl, nexts [i].dbl);
+        accum->dbl = dbl;
+      }
       break;
-    default:
-      g_error ("Should be a numeric value");
-      g_assert_not_reached ();
+    case UCL_REG_TYPE_REAL:
+      for (; i < n_nexts && nexts [i].type == UCL_REG_TYPE_REAL; i++)
+        mpfr_div (accum->real, accum->real, nexts [i].real, rnd);
       break;
     }
+
+    if (i < n_nexts)
+      ucl_arithmetic_div (accum, & nexts [i++]);
   }
-  else
+}
+
+/*
+ * Fused multiply-add, accum += a * b; exact types
+ * never round, and doubles and reals round once (so
+ * exact operands enter mpfr_fma at full width, and
+ * rationals, which have no such width, have the
+ * whole thing computed exactly and rounded last)
+ *
+ */
+
+static inline mpfr_srcptr
+_as_real (mpfr_ptr tmp, const UclReg* reg)
+{
+  switch (reg->type)
+  {
+  case UCL_REG_TYPE_WORD:
+    mpfr_init2 (tmp, sizeof (glong) * 8);
+    mpfr_set_si (tmp, reg->word, MPFR_RNDN);
+    break;
+  case UCL_REG_TYPE_INTEGER:
+    mpfr_init2 (tmp, MAX (MPFR_PREC_MIN, mpz_sizeinbase (reg->integer, 2)));
+    mpfr_set_z (tmp, reg->integer, MPFR_RNDN);
+    break;
+  case UCL_REG_TYPE_RATIONAL:
+    _ucl_mpfr_init (tmp);
+    mpfr_set_q (tmp, reg->rational, round);
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    mpfr_init2 (tmp, 53);
+    mpfr_set_d (tmp, reg->dbl, MPFR_RNDN);
+    break;
+  default:
+    return reg->real;
+  }
+return tmp;
+}
+
+static inline gboolean
+_as_rational (mpq_ptr tmp, const UclReg* reg)
+{
+  switch (reg->type)
+  {
+  case UCL_REG_TYPE_WORD:
+    mpq_set_si (tmp, reg->word, 1);
+    break;
+  case UCL_REG_TYPE_INTEGER:
+    mpq_set_z (tmp, reg->integer);
+    break;
+  case UCL_REG_TYPE_RATIONAL:
+    mpq_set (tmp, reg->rational);
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    if (!isfinite (reg->dbl))
+      return FALSE;
+    mpq_set_d (tmp, reg->dbl);
+    break;
+  default:
+    if (!mpfr_number_p (reg->real))
+      return FALSE;
+    mpfr_get_q (tmp, reg->real);
+    break;
+  }
+return TRUE;
+}
+
+static gboolean
+_fma_exact (UclReg* accum, const UclReg* a, const UclReg* b, UclRegType type)
+{
+  gboolean exact;
+  mpq_t x, y, z;
+
+  if (accum->type != UCL_REG_TYPE_RATIONAL
+    && a->type != UCL_REG_TYPE_RATIONAL
+    && b->type != UCL_REG_TYPE_RATIONAL)
+    return FALSE;
+
+  mpq_inits (x, y, z, NULL);
+
+  /* non-finite operands make rounding moot */
+  if ((exact = _as_rational (x, a)
+            && _as_rational (y, b)
+            && _as_rational (z, accum)))
   {
-    if (next->type < UCL_REG_TYPE_INTEGER
-      || next->type > UCL_REG_TYPE_REAL)
+    mpq_mul (x, x, y);
+    mpq_add (x, x, z);
+
+    ucl_reg_setup (accum, type);
+
+    if (type == UCL_REG_TYPE_REAL)
+      mpfr_set_q (accum->real, x, round);
+    else
     {
-      g_error ("Should be a numeric value");
-      g_assert_not_reached ();
+      mpfr_t tmp;
+      mpfr_init2 (tmp, 53);
+      mpfr_set_q (tmp, x, MPFR_RNDN);
+      accum->dbl = mpfr_get_d (tmp, MPFR_RNDN);
+      mpfr_clear (tmp);
     }
+  }
+
+  mpq_clears (x, y, z, NULL);
+return exact;
+}
+
+void
+ucl_arithmetic_fma (UclReg* accum, const UclReg* a, const UclReg* b)
+{
+  UclReg views [2];
+  mp_limb_t limbs [2];
+  UclRegType type;
+
+  if (a->type < UCL_REG_TYPE_WORD
+    || a->type > UCL_REG_TYPE_REAL
+    || b->type < UCL_REG_TYPE_WORD
+    || b->type > UCL_REG_TYPE_REAL
+    || (accum->type != UCL_REG_TYPE_VOID
+      && (accum->type < UCL_REG_TYPE_WORD
+        || accum->type > UCL_REG_TYPE_REAL)))
+  {
+    g_error ("Should be a numeric value");
+    g_assert_not_reached ();
+  }
+
+  if (accum->type == UCL_REG_TYPE_VOID)
+  {
+    ucl_arithmetic_mul (accum, a);
+    ucl_arithmetic_mul (accum, b);
+    return;
+  }
+
+  type = MAX (accum->type, MAX (a->type, b->type));
 
-    if (accum->type >= next->type)
+  switch (type)
+  {
+  case UCL_REG_TYPE_WORD:
     {
-      switch (accum->type)
+      glong word;
+      if (!__builtin_mul_overflow (a->word, b->word, &word)
+        && !__builtin_add_overflow (accum->word, word, &word))
       {
-      case UCL_REG_TYPE_INTEGER:
-        ucl_reg_cast (accum, accum, UCL_REG_TYPE_RATIONAL);
-        G_GNUC_FALLTHROUGH;
-      case UCL_REG_TYPE_RATIONAL:
-        switch (next->type)
-        {
-        case UCL_REG_TYPE_INTEGER:
-          {
-            mpz_ptr z = mpq_denref (accum->rational);
-            mpz_mul (z, z, next->integer);
-            mpq_canonicalize (accum->rational);
-          }
-          break;
-        case UCL_REG_TYPE_RATIONAL:
-          mpq_div (accum->rational, accum->rational, next->rational);
-          break;
-        }
-        break;
-      case UCL_REG_TYPE_REAL:
-        switch (next->type)
-        {
-        case UCL_REG_TYPE_INTEGER:
-          mpfr_div_z (accum->real, accum->real, next->integer, round);
-          break;
-        case UCL_REG_TYPE_RATIONAL:
-          mpfr_div_q (accum->real, accum->real, next->rational, round);
-          break;
-        case UCL_REG_TYPE_REAL:
-          mpfr_div (accum->real, accum->real, next->real, round);
-          break;
-        }
+        accum->word = word;
         break;
       }
     }
+    G_GNUC_FALLTHROUGH;
+  case UCL_REG_TYPE_INTEGER:
+    if (accum->type == UCL_REG_TYPE_WORD)
+      ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER);
+    if (a->type == UCL_REG_TYPE_WORD)
+      a = _word_view (&views [0], &limbs [0], a->word);
+    if (b->type == UCL_REG_TYPE_WORD)
+      b = _word_view (&views [1], &limbs [1], b->word);
+    mpz_addmul (accum->integer, a->integer, b->integer);
+    break;
+  case UCL_REG_TYPE_RATIONAL:
+    if (accum->type != UCL_REG_TYPE_RATIONAL)
+      ucl_reg_cast (accum, accum, UCL_REG_TYPE_RATIONAL);
+    if (a->type == UCL_REG_TYPE_WORD)
+      a = _word_view (&views [0], &limbs [0], a->word);
+    if (b->type == UCL_REG_TYPE_WORD)
+      b = _word_view (&views [1], &limbs [1], b->word);
+
+    if (a->type == UCL_REG_TYPE_INTEGER
+      && b->type == UCL_REG_TYPE_INTEGER)
+    {
+      /* n/d + z = (n + zd)/d stays in lowest terms */
+      mpz_t prod;
+      mpz_init (prod);
+      mpz_mul (prod, a->integer, b->integer);
+      mpz_addmul (mpq_numref (accum->rational), mpq_denref (accum->rational), prod);
+      mpz_clear (prod);
+    }
     else
     {
-      ucl_reg_cast (accum, accum, next->type);
-      ucl_arithmetic_div (accum, next);
+      UclReg prod = {0};
+      ucl_arithmetic_mul (&prod, a);
+      ucl_arithmetic_mul (&prod, b);
+      ucl_arithmetic_add (accum, &prod);
+      ucl_reg_unset (&prod);
+    }
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    if (_fma_exact (accum, a, b, type))
+      break;
+    if (accum->type != UCL_REG_TYPE_DOUBLE)
+      ucl_reg_cast (accum, accum, UCL_REG_TYPE_DOUBLE);
+    accum->dbl = fma (_as_double (a), _as_double (b), accum->dbl);
+    break;
+  case UCL_REG_TYPE_REAL:
+    {
+      mpfr_t tmps [2];
+      mpfr_srcptr x, y;
+
+      if (_fma_exact (accum, a, b, type))
+        break;
+      if (accum->type != UCL_REG_TYPE_REAL)
+        ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
+
+      x = _as_real (tmps [0], a);
+      y = _as_real (tmps [1], b);
+      mpfr_fma (accum->real, x, y, accum->real, round);
+
+      if (x == tmps [0])
+        mpfr_clear (tmps [0]);
+      if (y == tmps [1])
+        mpfr_clear (tmps [1]);
     }
+    break;
+  default:
+    g_assert_not_reached ();
+    break;
   }
 }
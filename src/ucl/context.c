@@ -0,0 +1,70 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <context.h>
+
+/*
+ * Current context is per-thread and borrowed; NULL
+ * stands for MPFR's own (also per-thread) defaults
+ *
+ */
+
+__thread const UclContext* _ucl_context_current = NULL;
+
+/* public API */
+
+void
+ucl_context_init (UclContext* context)
+{
+  g_return_if_fail (context != NULL);
+  context->precision = mpfr_get_default_prec ();
+  context->rounding = mpfr_get_default_rounding_mode ();
+  context->fast = FALSE;
+}
+
+const UclContext*
+ucl_context_enter (const UclContext* context)
+{
+  const UclContext* last = _ucl_context_current;
+  _ucl_context_current = context;
+return last;
+}
+
+void
+ucl_context_leave (const UclContext* last)
+{
+  _ucl_context_current = last;
+}
+
+mpfr_prec_t
+ucl_context_get_precision (void)
+{
+  return _ucl_context_precision ();
+}
+
+mpfr_rnd_t
+ucl_context_get_rounding (void)
+{
+  return _ucl_context_rounding ();
+}
+
+gboolean
+ucl_context_get_fast (void)
+{
+  return _ucl_context_fast ();
+}
@@ -0,0 +1,61 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __UCL_CONTEXT__
+#define __UCL_CONTEXT__ 1
+#ifndef __LIBABACO_UCL_INSIDE__
+# error "This is a private header"
+#endif // __LIBABACO_UCL_INSIDE__
+#include <libabaco_ucl.h>
+
+#define EXPORT G_GNUC_INTERNAL
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+EXPORT extern __thread const UclContext* _ucl_context_current;
+
+static inline mpfr_prec_t
+_ucl_context_precision (void)
+{
+  const UclContext* context = _ucl_context_current;
+return (context != NULL) ? context->precision : mpfr_get_default_prec ();
+}
+
+static inline mpfr_rnd_t
+_ucl_context_rounding (void)
+{
+  const UclContext* context = _ucl_context_current;
+return (context != NULL) ? context->rounding : mpfr_get_default_rounding_mode ();
+}
+
+static inline gboolean
+_ucl_context_fast (void)
+{
+  const UclContext* context = _ucl_context_current;
+return (context != NULL) && context->fast;
+}
+
+#define round (_ucl_context_rounding ())
+#define _ucl_mpfr_init(x) (mpfr_init2 ((x), _ucl_context_precision ()))
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __UCL_CONTEXT__
@@ -0,0 +1,83 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __UCL_KERNEL__
+#define __UCL_KERNEL__ 1
+#ifndef __LIBABACO_UCL_INSIDE__
+# error "This is a private header"
+#endif // __LIBABACO_UCL_INSIDE__
+#include <libabaco_ucl.h>
+
+#define EXPORT G_GNUC_INTERNAL
+#define UCL_N_TYPES (UCL_REG_TYPE_REAL + 1)
+
+/*
+ * Dense per-operation dispatch tables, indexed by
+ * [accum->type][next->type]; every cell holds a
+ * kernel, pairs which are not numeric abort
+ *
+ */
+
+typedef UclKernel UclKernelTable [UCL_N_TYPES][UCL_N_TYPES];
+
+#define UCL_KERNELS_INVALID \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+  }
+
+#define UCL_KERNELS_LOAD \
+  { \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_invalid, \
+    _ucl_kernel_load_word, \
+    _ucl_kernel_load_integer, \
+    _ucl_kernel_load_rational, \
+    _ucl_kernel_load_double, \
+    _ucl_kernel_load_real, \
+  }
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+EXPORT extern const UclKernelTable _ucl_kernels_pow;
+
+EXPORT void
+_ucl_kernel_invalid (UclReg* accum, const UclReg* next);
+EXPORT void
+_ucl_kernel_load_word (UclReg* accum, const UclReg* next);
+EXPORT void
+_ucl_kernel_load_integer (UclReg* accum, const UclReg* next);
+EXPORT void
+_ucl_kernel_load_rational (UclReg* accum, const UclReg* next);
+EXPORT void
+_ucl_kernel_load_double (UclReg* accum, const UclReg* next);
+EXPORT void
+_ucl_kernel_load_real (UclReg* accum, const UclReg* next);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#undef EXPORT
+#endif // __UCL_KERNEL__
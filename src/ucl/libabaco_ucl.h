@@ -32,16 +32,46 @@
 
 #define UCL_TYPE_REG (ucl_reg_get_type ())
 typedef struct _UclReg UclReg;
+typedef struct _UclContext UclContext;
+
+typedef enum
+{
+  UCL_FORMAT_EXACT = 0,       /* every digit the value holds  */
+  UCL_FORMAT_FIXED,           /* 'digits' after the point     */
+  UCL_FORMAT_SCIENTIFIC,      /* 'digits' significant digits  */
+  UCL_FORMAT_SHORTEST,        /* fewest digits reading back   */
+} UclFormat;
 
 typedef enum
 {
   UCL_REG_TYPE_VOID = 0,
   UCL_REG_TYPE_POINTER,
+  UCL_REG_TYPE_WORD,
   UCL_REG_TYPE_INTEGER,
   UCL_REG_TYPE_RATIONAL,
+  UCL_REG_TYPE_DOUBLE,
   UCL_REG_TYPE_REAL,
 } UclRegType;
 
+typedef enum
+{
+  UCL_OPERATOR_ADD = 0,
+  UCL_OPERATOR_SUB,
+  UCL_OPERATOR_MUL,
+  UCL_OPERATOR_DIV,
+  UCL_OPERATOR_POW,
+} UclOperator;
+
+/*
+ * Kernels fold 'next' into 'accum' (accum = accum op
+ * next) except for UCL_OPERATOR_POW, which follows
+ * ucl_power_pow: 'accum' holds the exponent, 'next'
+ * the base, and the power lands on 'accum'
+ *
+ */
+
+typedef void (*UclKernel) (UclReg* accum, const UclReg* next);
+
 #if __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -54,8 +84,10 @@ struct _UclReg
   union
   {
     gpointer pointer;
+    glong word;
     mpz_t integer;
     mpq_t rational;
+    gdouble dbl;
     mpfr_t real;
   };
 
@@ -63,6 +95,38 @@ struct _UclReg
   guint shadow : 1 G_GNUC_DEPRECATED;
 } __attribute__ ((aligned (sizeof (gpointer))));
 
+/*
+ * Precision and rounding used when real registers
+ * are created or computed; entered per thread. On
+ * fast contexts decimal literals load as doubles
+ *
+ */
+
+struct _UclContext
+{
+  mpfr_prec_t precision;
+  mpfr_rnd_t rounding;
+  gboolean fast;
+};
+
+/*
+ * context.c
+ *
+ */
+
+UCL_EXPORT void
+ucl_context_init (UclContext* context);
+UCL_EXPORT const UclContext*
+ucl_context_enter (const UclContext* context);
+UCL_EXPORT void
+ucl_context_leave (const UclContext* last);
+UCL_EXPORT mpfr_prec_t
+ucl_context_get_precision (void);
+UCL_EXPORT mpfr_rnd_t
+ucl_context_get_rounding (void);
+UCL_EXPORT gboolean
+ucl_context_get_fast (void);
+
 /*
  * unified.c
  *
@@ -108,6 +172,12 @@ double
 ucl_reg_save_double (const UclReg* reg);
 gchar*
 ucl_reg_save_string (const UclReg* reg, int base);
+UCL_EXPORT gsize
+ucl_reg_format_length (const UclReg* reg, int base, UclFormat format, guint digits);
+UCL_EXPORT gsize
+ucl_reg_format (const UclReg* reg, gchar* buffer, gsize size, int base, UclFormat format, guint digits);
+UCL_EXPORT gsize
+ucl_reg_format_append (const UclReg* reg, GString* buffer, int base, UclFormat format, guint digits);
 
 /*
  * arithmetic.c
@@ -122,6 +192,18 @@ UCL_EXPORT void
 ucl_arithmetic_mul (UclReg* accum, const UclReg* next);
 UCL_EXPORT void
 ucl_arithmetic_div (UclReg* accum, const UclReg* next);
+UCL_EXPORT void
+ucl_arithmetic_add_n (UclReg* accum, const UclReg* nexts, guint n_nexts);
+UCL_EXPORT void
+ucl_arithmetic_sub_n (UclReg* accum, const UclReg* nexts, guint n_nexts);
+UCL_EXPORT void
+ucl_arithmetic_mul_n (UclReg* accum, const UclReg* nexts, guint n_nexts);
+UCL_EXPORT void
+ucl_arithmetic_div_n (UclReg* accum, const UclReg* nexts, guint n_nexts);
+UCL_EXPORT void
+ucl_arithmetic_fma (UclReg* accum, const UclReg* a, const UclReg* b);
+UCL_EXPORT UclKernel
+ucl_arithmetic_kernel (UclOperator op, UclRegType accum, UclRegType next);
 
 /*
  * power.c
@@ -130,6 +212,12 @@ ucl_arithmetic_div (UclReg* accum, const UclReg* next);
 
 UCL_EXPORT void
 ucl_power_pow (UclReg* accum, const UclReg* next);
+UCL_EXPORT void
+ucl_power_sqrt (UclReg* accum);
+UCL_EXPORT void
+ucl_power_cbrt (UclReg* accum);
+UCL_EXPORT void
+ucl_power_rootn (UclReg* accum, gulong n);
 
 #if __cplusplus
 }
@@ -16,9 +16,145 @@
  *
  */
 #include <config.h>
+#include <context.h>
 #include <libabaco_ucl.h>
 
-#define round (mpfr_get_default_rounding_mode ())
+/*
+ * Literals whose digits fit a machine word are read
+ * natively, with powers of the base for denominators;
+ * only longer digit strings are handed to GMP
+ *
+ */
+
+static const guint64 _ucl_pow10 [] =
+{
+  G_GUINT64_CONSTANT (1),
+  G_GUINT64_CONSTANT (10),
+  G_GUINT64_CONSTANT (100),
+  G_GUINT64_CONSTANT (1000),
+  G_GUINT64_CONSTANT (10000),
+  G_GUINT64_CONSTANT (100000),
+  G_GUINT64_CONSTANT (1000000),
+  G_GUINT64_CONSTANT (10000000),
+  G_GUINT64_CONSTANT (100000000),
+  G_GUINT64_CONSTANT (1000000000),
+  G_GUINT64_CONSTANT (10000000000),
+  G_GUINT64_CONSTANT (100000000000),
+  G_GUINT64_CONSTANT (1000000000000),
+  G_GUINT64_CONSTANT (10000000000000),
+  G_GUINT64_CONSTANT (100000000000000),
+  G_GUINT64_CONSTANT (1000000000000000),
+  G_GUINT64_CONSTANT (10000000000000000),
+  G_GUINT64_CONSTANT (100000000000000000),
+  G_GUINT64_CONSTANT (1000000000000000000),
+  G_GUINT64_CONSTANT (10000000000000000000),
+};
+
+static inline gboolean
+_ucl_power (gulong* power, int base, gsize exp)
+{
+  gulong value = 1;
+
+  if (base == 10 && exp < G_N_ELEMENTS (_ucl_pow10))
+  {
+    if (_ucl_pow10 [exp] > G_MAXULONG)
+      return FALSE;
+    *power = (gulong) _ucl_pow10 [exp];
+    return TRUE;
+  }
+
+  while (exp-- > 0)
+  {
+    if (__builtin_mul_overflow (value, (gulong) base, &value))
+      return FALSE;
+  }
+
+  *power = value;
+return TRUE;
+}
+
+static inline gulong
+_ucl_gcd (gulong a, gulong b)
+{
+  while (b != 0)
+  {
+    gulong t = a % b;
+    a = b;
+    b = t;
+  }
+return a;
+}
+
+static inline const gchar*
+_ucl_sign (const gchar* expr, gboolean* negative)
+{
+  while (g_ascii_isspace (*expr))
+    ++expr;
+  *negative = (*expr == '-');
+  if (*expr == '-' || *expr == '+')
+    ++expr;
+return expr;
+}
+
+/* base 0 follows GMP: 0x, 0b and 0 prefixes */
+static inline const gchar*
+_ucl_radix (const gchar* digits, int* base)
+{
+  if (digits [0] == '0' && (digits [1] == 'x' || digits [1] == 'X'))
+  {
+    *base = 16;
+    return digits + 2;
+  }
+  else
+  if (digits [0] == '0' && (digits [1] == 'b' || digits [1] == 'B'))
+  {
+    *base = 2;
+    return digits + 2;
+  }
+
+  *base = (digits [0] == '0') ? 8 : 10;
+return digits;
+}
+
+static inline gboolean
+_ucl_digits (gulong* acc, const gchar* ptr, const gchar* top, int base)
+{
+  gulong value = *acc;
+  gint digit;
+
+  for (; ptr < top; ptr++)
+  {
+    if (*ptr >= '0' && *ptr <= '9')
+      digit = *ptr - '0';
+    else
+    if (*ptr >= 'a' && *ptr <= 'z')
+      digit = *ptr - 'a' + 10;
+    else
+    if (*ptr >= 'A' && *ptr <= 'Z')
+      digit = *ptr - 'A' + 10;
+    else
+      return FALSE;
+
+    if (digit >= base
+      || __builtin_mul_overflow (value, (gulong) base, &value)
+      || __builtin_add_overflow (value, (gulong) digit, &value))
+      return FALSE;
+  }
+
+  *acc = value;
+return TRUE;
+}
+
+static inline void
+_ucl_setq (mpq_ptr q, gboolean negative, gulong num, gulong den)
+{
+  gulong gcd = _ucl_gcd (num, den);
+
+  mpz_set_ui (mpq_numref (q), num / gcd);
+  mpz_set_ui (mpq_denref (q), den / gcd);
+  if (negative)
+    mpz_neg (mpq_numref (q), mpq_numref (q));
+}
 
 /* hidden API */
 
@@ -32,55 +168,114 @@ _ucl_loadq (mpq_t q, const gchar* expr, const gchar* dot, int base)
   mpz_ptr den = mpq_denref (q);
   const long bufsz = 512;
   gchar stat [bufsz + sizeof (void*)];
-  gsize length = strlen (expr);
-  guint t, partial = 0;
-  gchar* next = NULL;
+  const gchar* frac = g_utf8_next_char (dot);
+  const gchar* top = frac + strlen (frac);
+  const gchar* digits = NULL;
+  gboolean negative = FALSE;
+  gulong numw = 0, denw = 1;
+  gsize whole, partial;
   gchar* buf = NULL;
   int result;
 
-  partial = length - g_utf8_skip [*(guchar*) dot];
-  next = g_utf8_next_char (dot);
-  if (partial > bufsz)
-    buf = g_malloc (partial + 1);
+  digits = _ucl_sign (expr, &negative);
+  whole = dot - digits;
+  partial = top - frac;
+
+  if (base >= 2 && base <= 36
+    && whole + partial > 0
+    && _ucl_digits (&numw, digits, dot, base)
+    && _ucl_digits (&numw, frac, top, base)
+    && _ucl_power (&denw, base, partial))
+  {
+    _ucl_setq (q, negative, numw, denw);
+    return TRUE;
+  }
+
+  if (whole + partial > bufsz)
+    buf = g_malloc (whole + partial + 1);
   else
     buf = & stat [0];
 
-  t = dot - expr;
-  memcpy (& buf [0], expr, t);
-  memcpy (& buf [t], next, partial - t);
-  buf [partial] = '\0';
+  memcpy (& buf [0], digits, whole);
+  memcpy (& buf [whole], frac, partial);
+  buf [whole + partial] = '\0';
 
   result =
   mpz_set_str (num, buf, base);
+  if (buf != & stat [0])
+    g_free (buf);
   if (G_UNLIKELY (result < 0))
-  {
-    if (buf != & stat [0])
-      g_free (buf);
     return FALSE;
-  }
 
-  memset (& buf [1], '0', partial - 1);
-  buf [partial] = '\0';
-  buf [0] = '1';
+  if (negative)
+    mpz_neg (num, num);
 
-  result =
-  mpz_set_str (den, buf, base);
-  if (G_UNLIKELY (result < 0))
+  mpz_ui_pow_ui (den, (base == 0) ? 10 : base, partial);
+  mpq_canonicalize (q);
+return TRUE;
+}
+
+static inline gboolean
+_ucl_loadr (mpq_ptr q, const gchar* expr, const gchar* slash, int base)
+{
+  const gchar* next = slash + 1;
+  const gchar* digits = NULL;
+  gboolean negative = FALSE;
+  gulong num = 0, den = 0;
+
+  digits = _ucl_sign (expr, &negative);
+
+  if (base >= 2 && base <= 36
+    && digits < slash && *next != '\0'
+    && _ucl_digits (&num, digits, slash, base)
+    && _ucl_digits (&den, next, next + strlen (next), base))
   {
-    if (buf != & stat [0])
-      g_free (buf);
-    return FALSE;
-  }
+    if (G_UNLIKELY (den == 0))
+      return FALSE;
 
-  /* canonicalize */
+    _ucl_setq (q, negative, num, den);
+    return TRUE;
+  }
 
-  if (buf != & stat [0])
-    g_free (buf);
+  if (G_UNLIKELY (mpq_set_str (q, expr, base) < 0))
+    return FALSE;
+  if (G_UNLIKELY (mpz_sgn (mpq_denref (q)) == 0))
+    return FALSE;
 
   mpq_canonicalize (q);
 return TRUE;
 }
 
+static inline gboolean
+_ucl_loadw (glong* word, const gchar* expr, const gchar* top, int base)
+{
+  const gchar* digits = NULL;
+  gboolean negative = FALSE;
+  gulong value = 0;
+
+  digits = _ucl_sign (expr, &negative);
+  if (base == 0)
+    digits = _ucl_radix (digits, &base);
+  if (base < 2 || base > 36 || digits == top)
+    return FALSE;
+  if (!_ucl_digits (&value, digits, top, base))
+    return FALSE;
+
+  if (negative)
+  {
+    if (value > (gulong) G_MAXLONG + 1)
+      return FALSE;
+    *word = (glong) (0UL - value);
+  }
+  else
+  {
+    if (value > (gulong) G_MAXLONG)
+      return FALSE;
+    *word = (glong) value;
+  }
+return TRUE;
+}
+
 /* public API */
 
 void
@@ -93,8 +288,16 @@ ucl_reg_load_ldouble (UclReg* reg, long double value)
 void
 ucl_reg_load_double (UclReg* reg, double value)
 {
-  ucl_reg_setup (reg, UCL_REG_TYPE_RATIONAL);
-  mpq_set_d (reg->rational, value);
+  if (_ucl_context_fast ())
+  {
+    ucl_reg_setup (reg, UCL_REG_TYPE_DOUBLE);
+    reg->dbl = value;
+  }
+  else
+  {
+    ucl_reg_setup (reg, UCL_REG_TYPE_RATIONAL);
+    mpq_set_d (reg->rational, value);
+  }
 }
 
 gboolean
@@ -102,11 +305,36 @@ ucl_reg_load_string (UclReg* reg, const gchar* expr, int base)
 {
   const gchar* val = expr;
 
+  /* fast contexts read plain decimals as doubles */
+  if (base == 10 && _ucl_context_fast ())
+  {
+    gchar* end = NULL;
+    gdouble value;
+
+    value = g_ascii_strtod (expr, &end);
+    if (end != expr && *end == 0)
+    {
+      ucl_reg_setup (reg, UCL_REG_TYPE_DOUBLE);
+      reg->dbl = value;
+      return TRUE;
+    }
+  }
+
   do
   {
     switch (*val)
     {
     case 0:
+      {
+        glong word;
+        if (_ucl_loadw (&word, expr, val, base))
+        {
+          ucl_reg_setup (reg, UCL_REG_TYPE_WORD);
+          reg->word = word;
+          return TRUE;
+        }
+      }
+
       ucl_reg_setup (reg, UCL_REG_TYPE_INTEGER);
       return ! (mpz_set_str (reg->integer, expr, base) < 0);
     case '.':
@@ -114,10 +342,7 @@ ucl_reg_load_string (UclReg* reg, const gchar* expr, int base)
       return _ucl_loadq (reg->rational, expr, val, base);
     case '/':
       ucl_reg_setup (reg, UCL_REG_TYPE_RATIONAL);
-      if (G_UNLIKELY (mpq_set_str (reg->rational, expr, base) < 0))
-        return FALSE;
-      mpq_canonicalize (reg->rational);
-      return TRUE;
+      return _ucl_loadr (reg->rational, expr, val, base);
     }
 
     val = g_utf8_next_char (val);
@@ -16,18 +16,13 @@
  *
  */
 #include <config.h>
+#include <math.h>
+#include <context.h>
+#include <kernel.h>
 #include <libabaco_ucl.h>
 
-#define round (mpfr_get_default_rounding_mode ())
 static const UclReg __empty__ = {0};
 
-#define fresh(reg, _type) \
-  G_STMT_START { \
-    UclReg* __reg = (reg); \
-    ucl_reg_clear (__reg); \
-    __reg->type = (_type); \
-  } G_STMT_END
-
 #if !HAVE_MEMCPY
 # define do_save(dst,src,ctype) memcpy ((dst), (src), sizeof (ctype));
 #else // !HAVE_MEMCPY
@@ -44,92 +39,288 @@ static const UclReg __empty__ = {0};
   do_save (exp, accum->member, ctype); \
   *accum = __empty__;
 
-void
-ucl_power_pow (UclReg* accum, const UclReg* next)
+/*
+ * Pow kernels raise 'next' to the power of 'accum';
+ * doubles win over exact types, but not over reals,
+ * and otherwise powers are computed on full precision
+ * types (integral exponents staying exact)
+ *
+ */
+
+static inline void
+_load_real (UclReg* accum, const UclReg* next)
+{
+  if (next->type == UCL_REG_TYPE_REAL)
+    ucl_reg_copy (accum, next);
+  else
+    ucl_reg_cast (accum, next, UCL_REG_TYPE_REAL);
+}
+
+static void
+_pow_d (UclReg* accum, const UclReg* next)
+{
+  gdouble value;
+
+  value = pow (ucl_reg_save_double (next), ucl_reg_save_double (accum));
+  ucl_reg_setup (accum, UCL_REG_TYPE_DOUBLE);
+  accum->dbl = value;
+}
+
+static void
+_pow_z (UclReg* accum, const UclReg* next)
 {
-  if (accum->type == UCL_REG_TYPE_VOID)
+  UclReg base = {0};
+
+  if (next->type == UCL_REG_TYPE_WORD)
   {
-    switch (next->type)
+    ucl_reg_cast (&base, next, UCL_REG_TYPE_INTEGER);
+    next = &base;
+  }
+
+  if (accum->type == UCL_REG_TYPE_WORD)
+    ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER);
+
+  {
+    save (mpz_t, integer);
+    if (mpz_fits_uint_p (exp))
     {
-    case UCL_REG_TYPE_INTEGER:
-      fresh (accum, next->type);
-      mpz_init (accum->integer);
-      mpz_set (accum->integer, next->integer);
-      break;
-    case UCL_REG_TYPE_RATIONAL:
-      fresh (accum, next->type);
-      mpq_init (accum->rational);
-      mpq_set (accum->rational, next->rational);
-      break;
-    case UCL_REG_TYPE_REAL:
-      fresh (accum, next->type);
-      mpfr_init (accum->real);
-      mpfr_set (accum->real, next->real, round);
-      break;
-    default:
-      g_error ("Should be a numeric value");
-      g_assert_not_reached ();
-      break;
+      unsigned int iexp;
+      iexp = mpz_get_ui (exp);
+      switch (next->type)
+      {
+      case UCL_REG_TYPE_INTEGER:
+        ucl_reg_setup (accum, next->type);
+        mpz_pow_ui (accum->integer, next->integer, iexp);
+        break;
+      case UCL_REG_TYPE_RATIONAL:
+        ucl_reg_setup (accum, next->type);
+        mpz_pow_ui (mpq_numref (accum->rational), mpq_numref (next->rational), iexp);
+        mpz_pow_ui (mpq_denref (accum->rational), mpq_denref (next->rational), iexp);
+        mpq_canonicalize (accum->rational);
+        break;
+      case UCL_REG_TYPE_REAL:
+        ucl_reg_setup (accum, next->type);
+        mpfr_pow_ui (accum->real, next->real, iexp, round);
+        break;
+      default:
+        mpz_clear (exp);
+        g_error ("Should be a numeric value");
+        g_assert_not_reached ();
+        break;
+      }
+    }
+    else
+    {
+      _load_real (accum, next);
+      mpfr_pow_z (accum->real, accum->real, exp, round);
     }
+
+    mpz_clear (exp);
   }
-  else
+
+  ucl_reg_unset (&base);
+}
+
+static void
+_pow_r (UclReg* accum, const UclReg* next)
+{
+  if (accum->type != UCL_REG_TYPE_REAL)
+    ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
+
+  {
+    save (mpfr_t, real);
+    _load_real (accum, next);
+    mpfr_pow (accum->real, accum->real, exp, round);
+    mpfr_clear (exp);
+  }
+}
+
+const UclKernelTable _ucl_kernels_pow =
+{
+  UCL_KERNELS_LOAD,
+  UCL_KERNELS_INVALID,
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _pow_z,
+    _pow_z,
+    _pow_z,
+    _pow_d,
+    _pow_z,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _pow_z,
+    _pow_z,
+    _pow_z,
+    _pow_d,
+    _pow_z,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _pow_r,
+    _pow_r,
+    _pow_r,
+    _pow_d,
+    _pow_r,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _pow_d,
+    _pow_d,
+    _pow_d,
+    _pow_d,
+    _pow_r,
+  },
+  {
+    _ucl_kernel_invalid,
+    _ucl_kernel_invalid,
+    _pow_r,
+    _pow_r,
+    _pow_r,
+    _pow_r,
+    _pow_r,
+  },
+};
+
+void
+ucl_power_pow (UclReg* accum, const UclReg* next)
+{
+  _ucl_kernels_pow [accum->type] [next->type] (accum, next);
+}
+
+/*
+ * Root kernels; integers and rationals stay exact
+ * whenever the root is, anything else goes real
+ *
+ */
+
+static inline gboolean
+_z_root (mpz_ptr root, mpz_srcptr op, gulong n)
+{
+  if (mpz_sgn (op) < 0 && (n & 1) == 0)
+    return FALSE;
+  if (n == 2)
+  {
+    if (!mpz_perfect_square_p (op))
+      return FALSE;
+    mpz_sqrt (root, op);
+    return TRUE;
+  }
+return mpz_root (root, op, n) != 0;
+}
+
+static inline void
+_fr_root (mpfr_ptr x, gulong n)
+{
+  switch (n)
   {
-    switch (accum->type)
+  case 2:
+    mpfr_sqrt (x, x, round);
+    break;
+  case 3:
+    mpfr_cbrt (x, x, round);
+    break;
+  default:
+#if MPFR_VERSION >= MPFR_VERSION_NUM(4,0,0)
+    mpfr_rootn_ui (x, x, n, round);
+#else // MPFR_VERSION < 4.0.0
+    mpfr_root (x, x, n, round);
+#endif // MPFR_VERSION
+    break;
+  }
+}
+
+static inline gdouble
+_d_root (gdouble x, gulong n)
+{
+  switch (n)
+  {
+  case 2:
+    return sqrt (x);
+  case 3:
+    return cbrt (x);
+  default:
+    if (x < 0 && (n & 1) != 0)
+      return - pow (- x, 1.0 / (gdouble) n);
+    return pow (x, 1.0 / (gdouble) n);
+  }
+}
+
+void
+ucl_power_rootn (UclReg* accum, gulong n)
+{
+  g_return_if_fail (n > 0);
+
+  switch (accum->type)
+  {
+  case UCL_REG_TYPE_WORD:
+    ucl_reg_cast (accum, accum, UCL_REG_TYPE_INTEGER);
+    ucl_power_rootn (accum, n);
+    if (accum->type == UCL_REG_TYPE_INTEGER)
+      ucl_reg_cast (accum, accum, UCL_REG_TYPE_WORD);
+    break;
+  case UCL_REG_TYPE_INTEGER:
     {
-    case UCL_REG_TYPE_INTEGER:
+      mpz_t root;
+      mpz_init (root);
+
+      if (_z_root (root, accum->integer, n))
+        mpz_swap (root, accum->integer);
+      else
       {
-        save (mpz_t, integer);
-        if (mpz_fits_uint_p (exp))
-        {
-          unsigned int iexp;
-          iexp = mpz_get_ui (exp);
-          switch (next->type)
-          {
-          case UCL_REG_TYPE_INTEGER:
-            ucl_reg_setup (accum, next->type);
-            mpz_pow_ui (accum->integer, next->integer, iexp);
-            break;
-          case UCL_REG_TYPE_RATIONAL:
-            ucl_reg_setup (accum, next->type);
-            mpz_pow_ui (mpq_numref (accum->rational), mpq_numref (next->rational), iexp);
-            mpz_pow_ui (mpq_denref (accum->rational), mpq_denref (next->rational), iexp);
-            mpq_canonicalize (accum->rational);
-            break;
-          case UCL_REG_TYPE_REAL:
-            ucl_reg_setup (accum, next->type);
-            mpfr_pow_ui (accum->real, next->real, iexp, round);
-            break;
-          default:
-            mpz_clear (exp);
-            g_error ("Should be a numeric value");
-            g_assert_not_reached ();
-            break;
-          }
-        }
-        else
-        {
-          ucl_reg_cast (accum, next, UCL_REG_TYPE_REAL);
-          mpfr_pow_z (accum->real, next->real, exp, round);
-        }
+        ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
+        _fr_root (accum->real, n);
+      }
 
-        mpz_clear (exp);
+      mpz_clear (root);
+    }
+    break;
+  case UCL_REG_TYPE_RATIONAL:
+    {
+      mpz_t num, den;
+      mpz_inits (num, den, NULL);
+
+      /* roots of coprime terms stay coprime */
+      if (_z_root (num, mpq_numref (accum->rational), n)
+        && _z_root (den, mpq_denref (accum->rational), n))
+      {
+        mpz_swap (num, mpq_numref (accum->rational));
+        mpz_swap (den, mpq_denref (accum->rational));
       }
-      break;
-    case UCL_REG_TYPE_RATIONAL:
-      ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
-      G_GNUC_FALLTHROUGH;
-    case UCL_REG_TYPE_REAL:
+      else
       {
-        save (mpfr_t, real);
-        ucl_reg_cast (accum, next, UCL_REG_TYPE_REAL);
-        mpfr_pow (accum->real, accum->real, exp, round);
-        mpfr_clear (exp);
+        ucl_reg_cast (accum, accum, UCL_REG_TYPE_REAL);
+        _fr_root (accum->real, n);
       }
-      break;
-    default:
-      g_error ("Should be a numeric value");
-      g_assert_not_reached ();
-      break;
+
+      mpz_clears (num, den, NULL);
     }
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    accum->dbl = _d_root (accum->dbl, n);
+    break;
+  case UCL_REG_TYPE_REAL:
+    _fr_root (accum->real, n);
+    break;
+  default:
+    g_error ("Should be a numeric value");
+    g_assert_not_reached ();
+    break;
   }
 }
+
+void
+ucl_power_sqrt (UclReg* accum)
+{
+  ucl_power_rootn (accum, 2);
+}
+
+void
+ucl_power_cbrt (UclReg* accum)
+{
+  ucl_power_rootn (accum, 3);
+}
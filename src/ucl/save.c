@@ -16,9 +16,227 @@
  *
  */
 #include <config.h>
+#include <float.h>
+#include <math.h>
+#include <context.h>
 #include <libabaco_ucl.h>
 
-#define round (mpfr_get_default_rounding_mode ())
+#define WORD_DIGITS (sizeof (glong) * 8)
+#define SCRATCH_SIZE (256)
+
+/*
+ * Formatting writes into caller storage which holds
+ * at least ucl_reg_format_length bytes, an upper bound
+ * (nul included) taken from operand sizes, so nothing
+ * is allocated on the way but for very long reals
+ *
+ */
+
+static inline gsize
+_digits_of (gdouble bits, int base)
+{
+  return (gsize) ceil (bits / log2 ((gdouble) base));
+}
+
+static inline gsize
+_real_length (mpfr_prec_t prec, mpfr_exp_t binexp, int base, UclFormat format, guint digits)
+{
+  gsize whole = _digits_of ((gdouble) ABS (binexp), base) + 2;
+
+  if (base == 10)
+  switch (format)
+  {
+  case UCL_FORMAT_FIXED:
+    return whole + digits + 4;
+  case UCL_FORMAT_SCIENTIFIC:
+    return digits + 32;
+  default:
+    break;
+  }
+return 1 + _digits_of ((gdouble) prec, base) + whole + 5;
+}
+
+static inline gsize
+_format_nonfinite (gchar* out, gboolean nan, gboolean negative)
+{
+  const gchar* text = nan ? "nan" : (negative ? "-inf" : "inf");
+  gsize length = strlen (text);
+  memcpy (out, text, length + 1);
+return length;
+}
+
+/* 0.DIGITS x base^exp, positionally */
+static gsize
+_place (gchar* out, gboolean negative, const gchar* digits, gsize n, mpfr_exp_t exp)
+{
+  gchar* ptr = out;
+
+  if (negative)
+    *ptr++ = '-';
+
+  if (exp > 0)
+  {
+    gsize whole = (gsize) exp;
+    if (whole >= n)
+    {
+      memcpy (ptr, digits, n);
+      ptr += n;
+      memset (ptr, '0', whole - n);
+      ptr += whole - n;
+      *ptr++ = '.';
+      *ptr++ = '0';
+    }
+    else
+    {
+      memcpy (ptr, digits, whole);
+      ptr += whole;
+      *ptr++ = '.';
+      memcpy (ptr, digits + whole, n - whole);
+      ptr += n - whole;
+    }
+  }
+  else
+  {
+    *ptr++ = '0';
+    *ptr++ = '.';
+    memset (ptr, '0', (gsize) -exp);
+    ptr += (gsize) -exp;
+    memcpy (ptr, digits, n);
+    ptr += n;
+  }
+
+  *ptr = '\0';
+return ptr - out;
+}
+
+/*
+ * Fewest digits which read back (to nearest, at the
+ * same precision) as the same real; candidates start
+ * where every digit is significant, so for 53 bits
+ * this is the usual 15 to 17 digits search
+ *
+ */
+
+static gsize
+_shortest (gchar* digits, mpfr_exp_t* exp, mpfr_srcptr x, int base, gsize n0)
+{
+  const mpfr_prec_t prec = mpfr_get_prec (x);
+  gchar stat [SCRATCH_SIZE + 32];
+  gsize lo = _digits_of ((gdouble) (prec - 1), base);
+  gsize limbsz = mpfr_custom_get_size (prec);
+  gpointer limbs = NULL;
+  gchar* back = NULL;
+  gsize n;
+  mpfr_t y;
+
+  if (lo < 1)
+    lo = 1;
+  if (lo > 1)
+    --lo;
+
+  back = (n0 <= SCRATCH_SIZE) ? & stat [0] : g_malloc (n0 + 32);
+  limbs = (limbsz <= SCRATCH_SIZE * 4) ? g_alloca (limbsz) : g_malloc (limbsz);
+  mpfr_custom_init (limbs, prec);
+  mpfr_custom_init_set (y, MPFR_ZERO_KIND, 0, prec, limbs);
+
+  for (n = lo; n < n0; n++)
+  {
+    mpfr_get_str (digits, exp, base, n, x, MPFR_RNDN);
+    g_snprintf (back, n0 + 32, "0.%s@%li", (digits [0] == '-') ? digits + 1 : digits, (glong) *exp);
+    mpfr_set_str (y, back, base, MPFR_RNDN);
+    if (mpfr_cmpabs (y, x) == 0)
+      break;
+  }
+
+  if (n == n0)
+    mpfr_get_str (digits, exp, base, n, x, MPFR_RNDN);
+  if (back != & stat [0])
+    g_free (back);
+  if (limbsz > SCRATCH_SIZE * 4)
+    g_free (limbs);
+return n;
+}
+
+static gsize
+_format_real (gchar* out, gsize size, mpfr_srcptr x, int base, UclFormat format, guint digits)
+{
+  gchar stat [SCRATCH_SIZE + 2];
+  gchar* scratch = NULL;
+  const gchar* first = NULL;
+  mpfr_exp_t exp;
+  gsize n, n0;
+
+  if (base == 10)
+  switch (format)
+  {
+  case UCL_FORMAT_FIXED:
+    return mpfr_snprintf (out, size, "%.*R*f", (int) digits, round, x);
+  case UCL_FORMAT_SCIENTIFIC:
+    return mpfr_snprintf (out, size, "%.*R*e", (int) (digits > 0 ? digits - 1 : 0), round, x);
+  default:
+    break;
+  }
+
+  if (mpfr_nan_p (x) || mpfr_inf_p (x))
+    return _format_nonfinite (out, mpfr_nan_p (x), mpfr_signbit (x));
+
+  n0 = 1 + _digits_of ((gdouble) mpfr_get_prec (x), base);
+  scratch = (n0 <= SCRATCH_SIZE) ? & stat [0] : g_malloc (n0 + 2);
+
+  if (format == UCL_FORMAT_SHORTEST)
+  {
+    n = _shortest (scratch, &exp, x, base, n0);
+    first = (scratch [0] == '-') ? scratch + 1 : scratch;
+    while (n > 1 && first [n - 1] == '0')
+      --n;
+  }
+  else
+  {
+    mpfr_get_str (scratch, &exp, base, n0, x, round);
+    first = (scratch [0] == '-') ? scratch + 1 : scratch;
+    n = n0;
+  }
+
+  n = _place (out, scratch [0] == '-', first, n, exp);
+  if (scratch != & stat [0])
+    g_free (scratch);
+return n;
+}
+
+static gsize
+_format_double (gchar* out, gsize size, gdouble value, int base, UclFormat format, guint digits)
+{
+  gchar spec [16];
+
+  if (base != 10)
+  {
+    MPFR_DECL_INIT (cast, DBL_MANT_DIG);
+    mpfr_set_d (cast, value, MPFR_RNDN);
+    return _format_real (out, size, cast, base, format, digits);
+  }
+
+  switch (format)
+  {
+  case UCL_FORMAT_FIXED:
+    g_snprintf (spec, sizeof (spec), "%%.%uf", digits);
+    break;
+  case UCL_FORMAT_SCIENTIFIC:
+    g_snprintf (spec, sizeof (spec), "%%.%ue", digits > 0 ? digits - 1 : 0);
+    break;
+  default:
+    if (!isfinite (value))
+      return _format_nonfinite (out, isnan (value), value < 0);
+
+    /* shortest of %.15g and %.17g which reads back */
+    g_ascii_formatd (out, size, "%.15g", value);
+    if (g_ascii_strtod (out, NULL) != value)
+      g_ascii_formatd (out, size, "%.17g", value);
+    return strlen (out);
+  }
+
+  g_ascii_formatd (out, size, spec, value);
+return strlen (out);
+}
 
 long double
 ucl_reg_save_ldouble (const UclReg* reg)
@@ -27,6 +245,12 @@ ucl_reg_save_ldouble (const UclReg* reg)
 
   switch (reg->type)
   {
+  case UCL_REG_TYPE_WORD:
+    result = (long double) reg->word;
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    result = (long double) reg->dbl;
+    break;
   case UCL_REG_TYPE_INTEGER:
   case UCL_REG_TYPE_RATIONAL:
     {
@@ -48,83 +272,113 @@ ucl_reg_save_double (const UclReg* reg)
 {
   switch (reg->type)
   {
+  case UCL_REG_TYPE_WORD:
+    return (double) reg->word;
   case UCL_REG_TYPE_INTEGER:
     return mpz_get_d (reg->integer);
   case UCL_REG_TYPE_RATIONAL:
     return mpq_get_d (reg->rational);
+  case UCL_REG_TYPE_DOUBLE:
+    return reg->dbl;
   case UCL_REG_TYPE_REAL:
     return mpfr_get_d (reg->real, round);
   }
 }
 
-gchar*
-ucl_reg_save_string (const UclReg* reg, int base)
+gsize
+ucl_reg_format_length (const UclReg* reg, int base, UclFormat format, guint digits)
 {
-  gchar* result = NULL;
-  gsize length = 0;
-
   switch (reg->type)
   {
+  case UCL_REG_TYPE_WORD:
+    return WORD_DIGITS + 2;
   case UCL_REG_TYPE_INTEGER:
-    length = 2;
-    length += mpz_sizeinbase (reg->integer, base);
-    result = g_malloc (length);
-    result = mpz_get_str (result, base, reg->integer);
-    break;
+    return mpz_sizeinbase (reg->integer, base) + 2;
   case UCL_REG_TYPE_RATIONAL:
-    length = 3;
-    length += mpz_sizeinbase (mpq_numref (reg->rational), base);
-    length += mpz_sizeinbase (mpq_denref (reg->rational), base);
-    result = mpq_get_str (g_malloc (length), base, reg->rational);
-    break;
+    return mpz_sizeinbase (mpq_numref (reg->rational), base)
+         + mpz_sizeinbase (mpq_denref (reg->rational), base) + 3;
+  case UCL_REG_TYPE_DOUBLE:
+    if (base == 10 && format != UCL_FORMAT_FIXED && format != UCL_FORMAT_SCIENTIFIC)
+      return G_ASCII_DTOSTR_BUF_SIZE;
+    else
+    {
+      int binexp = 0;
+      if (isfinite (reg->dbl))
+        frexp (reg->dbl, &binexp);
+      return _real_length (DBL_MANT_DIG, binexp, base, format, digits);
+    }
   case UCL_REG_TYPE_REAL:
     {
-      mpfr_exp_t exp;
-      gsize partial;
-      gchar* tmp;
-
-      tmp =
-      mpfr_get_str (NULL, &exp, base, 0, reg->real, round);
-      g_assert (tmp != NULL);
-
-      length = strlen (tmp);
-
-      if (exp >= 0)
-      {
-        partial = ((length > exp) ? length : exp + 1) + 1;
-        if (exp != 0)
-          result = g_malloc (partial + 1);
-        else
-        {
-          result = g_malloc (partial + 2);
-          result [0] = '0';
-          ++result;
-        }
-
-        memset (result, '0', partial);
-        memcpy (& result [      0], & tmp [  0], (length > exp) ?          exp : length);
-        memcpy (& result [exp + 1], & tmp [exp], (length > exp) ? length - exp :      0);
-        result [partial] = '\0';
-        result [exp] = '.';
-
-        if (exp == 0)
-          --result;
-      }
-      else
-      {
-        exp = -exp;
-        partial = length + exp + 2;
-        result = g_malloc (partial + 1);
-
-        memset (result, '0', partial);
-        memcpy (& result [exp + 2], tmp, length);
-        result [partial] = '\0';
-        result [1] = '.';
-      }
-
-      mpfr_free_str (tmp);
+      mpfr_exp_t binexp = 0;
+      if (mpfr_regular_p (reg->real))
+        binexp = mpfr_get_exp (reg->real);
+      return _real_length (mpfr_get_prec (reg->real), binexp, base, format, digits);
     }
-    break;
+  default:
+    return 0;
+  }
+}
+
+gsize
+ucl_reg_format (const UclReg* reg, gchar* buffer, gsize size, int base, UclFormat format, guint digits)
+{
+  gsize length = ucl_reg_format_length (reg, base, format, digits);
+
+  if (length == 0 || size < length)
+    return 0;
+
+  switch (reg->type)
+  {
+  case UCL_REG_TYPE_WORD:
+    if (base == 10)
+      return g_snprintf (buffer, size, "%li", reg->word);
+    else
+    {
+      mp_limb_t limb;
+      mpz_t view;
+
+      limb = (reg->word < 0) ? - (mp_limb_t) reg->word : (mp_limb_t) reg->word;
+      mpz_roinit_n (view, &limb, (reg->word < 0) ? -1 : (reg->word > 0));
+      return strlen (mpz_get_str (buffer, base, view));
+    }
+  case UCL_REG_TYPE_INTEGER:
+    return strlen (mpz_get_str (buffer, base, reg->integer));
+  case UCL_REG_TYPE_RATIONAL:
+    return strlen (mpq_get_str (buffer, base, reg->rational));
+  case UCL_REG_TYPE_DOUBLE:
+    return _format_double (buffer, size, reg->dbl, base, format, digits);
+  case UCL_REG_TYPE_REAL:
+    return _format_real (buffer, size, reg->real, base, format, digits);
+  default:
+    return 0;
+  }
+}
+
+gsize
+ucl_reg_format_append (const UclReg* reg, GString* buffer, int base, UclFormat format, guint digits)
+{
+  gsize length = ucl_reg_format_length (reg, base, format, digits);
+  gsize offset = buffer->len;
+
+  if (length == 0)
+    return 0;
+
+  g_string_set_size (buffer, offset + length);
+  length = ucl_reg_format (reg, buffer->str + offset, length, base, format, digits);
+  g_string_truncate (buffer, offset + length);
+return length;
+}
+
+gchar*
+ucl_reg_save_string (const UclReg* reg, int base)
+{
+  gsize length = ucl_reg_format_length (reg, base, UCL_FORMAT_EXACT, 0);
+  gchar* result = NULL;
+
+  if (length > 0)
+  {
+    result = g_malloc (length);
+    ucl_reg_format (reg, result, length, base, UCL_FORMAT_EXACT, 0);
   }
 return result;
 }
@@ -16,7 +16,9 @@
  *
  */
 #include <config.h>
+#include <context.h>
 #include <libabaco_ucl.h>
+#include <math.h>
 
 static const UclReg __empty__ = {0};
 
@@ -59,6 +61,12 @@ _reg_setup (UclReg* reg, UclRegType type)
     reg->type = type;
     break;
 
+  case UCL_REG_TYPE_WORD:
+    reg->word = 0;
+    goto assign;
+  case UCL_REG_TYPE_DOUBLE:
+    reg->dbl = 0;
+    goto assign;
   case UCL_REG_TYPE_INTEGER:
     mpz_init (reg->integer);
     goto assign;
@@ -66,7 +74,7 @@ _reg_setup (UclReg* reg, UclRegType type)
     mpq_init (reg->rational);
     goto assign;
   case UCL_REG_TYPE_REAL:
-    mpfr_init (reg->real);
+    _ucl_mpfr_init (reg->real);
     goto assign;
   }
 }
@@ -80,6 +88,8 @@ _reg_unset (UclReg* reg)
     *reg = __empty__;
     break;
   case UCL_REG_TYPE_POINTER:
+  case UCL_REG_TYPE_WORD:
+  case UCL_REG_TYPE_DOUBLE:
     goto cleanup;
   case UCL_REG_TYPE_INTEGER:
     mpz_clear (reg->integer);
@@ -93,7 +103,13 @@ _reg_unset (UclReg* reg)
   }
 }
 
-#define round (mpfr_get_default_rounding_mode ())
+/*
+ * Casting to a word never truncates: a value whose
+ * integral part does not fit a long is kept as an
+ * integer instead, and a non-finite one keeps its
+ * own type, so callers must check what they got
+ *
+ */
 
 static inline void
 _cast (UclReg* reg, const UclReg* from, UclRegType type)
@@ -101,15 +117,46 @@ _cast (UclReg* reg, const UclReg* from, UclRegType type)
   reg->type = type;
   switch (from->type)
   {
+  case UCL_REG_TYPE_WORD:
+    switch (type)
+    {
+    case UCL_REG_TYPE_INTEGER:
+      mpz_init_set_si (reg->integer, from->word);
+      break;
+    case UCL_REG_TYPE_RATIONAL:
+      mpq_init (reg->rational);
+      mpq_set_si (reg->rational, from->word, 1);
+      break;
+    case UCL_REG_TYPE_DOUBLE:
+      reg->dbl = (gdouble) from->word;
+      break;
+    case UCL_REG_TYPE_REAL:
+      _ucl_mpfr_init (reg->real);
+      mpfr_set_si (reg->real, from->word, round);
+      break;
+    }
+    break;
   case UCL_REG_TYPE_INTEGER:
     switch (type)
     {
+    case UCL_REG_TYPE_WORD:
+      if (mpz_fits_slong_p (from->integer))
+        reg->word = mpz_get_si (from->integer);
+      else
+      {
+        reg->type = UCL_REG_TYPE_INTEGER;
+        mpz_init_set (reg->integer, from->integer);
+      }
+      break;
     case UCL_REG_TYPE_RATIONAL:
       mpq_init (reg->rational);
       mpq_set_z (reg->rational, from->integer);
       break;
+    case UCL_REG_TYPE_DOUBLE:
+      reg->dbl = mpz_get_d (from->integer);
+      break;
     case UCL_REG_TYPE_REAL:
-      mpfr_init (reg->real);
+      _ucl_mpfr_init (reg->real);
       mpfr_set_z (reg->real, from->integer, round);
       break;
     }
@@ -117,12 +164,31 @@ _cast (UclReg* reg, const UclReg* from, UclRegType type)
   case UCL_REG_TYPE_RATIONAL:
     switch (type)
     {
+    case UCL_REG_TYPE_WORD:
+      {
+        mpz_t z;
+        mpz_init (z);
+        mpz_set_q (z, from->rational);
+        if (mpz_fits_slong_p (z))
+          reg->word = mpz_get_si (z);
+        else
+        {
+          reg->type = UCL_REG_TYPE_INTEGER;
+          mpz_init (reg->integer);
+          mpz_swap (reg->integer, z);
+        }
+        mpz_clear (z);
+      }
+      break;
     case UCL_REG_TYPE_INTEGER:
       mpz_init (reg->integer);
       mpz_set_q (reg->integer, from->rational);
       break;
+    case UCL_REG_TYPE_DOUBLE:
+      reg->dbl = mpq_get_d (from->rational);
+      break;
     case UCL_REG_TYPE_REAL:
-      mpfr_init (reg->real);
+      _ucl_mpfr_init (reg->real);
       mpfr_set_q (reg->real, from->rational, round);
       break;
     }
@@ -130,6 +196,23 @@ _cast (UclReg* reg, const UclReg* from, UclRegType type)
   case UCL_REG_TYPE_REAL:
     switch (type)
     {
+    case UCL_REG_TYPE_WORD:
+      if (mpfr_fits_slong_p (from->real, round))
+        reg->word = mpfr_get_si (from->real, round);
+      else
+      if (mpfr_number_p (from->real))
+      {
+        reg->type = UCL_REG_TYPE_INTEGER;
+        mpz_init (reg->integer);
+        mpfr_get_z (reg->integer, from->real, round);
+      }
+      else
+      {
+        reg->type = UCL_REG_TYPE_REAL;
+        _ucl_mpfr_init (reg->real);
+        mpfr_set (reg->real, from->real, round);
+      }
+      break;
     case UCL_REG_TYPE_INTEGER:
       mpz_init (reg->integer);
       mpfr_get_z (reg->integer, from->real, round);
@@ -138,6 +221,41 @@ _cast (UclReg* reg, const UclReg* from, UclRegType type)
       mpq_init (reg->rational);
       mpfr_get_q (reg->rational, from->real);
       break;
+    case UCL_REG_TYPE_DOUBLE:
+      reg->dbl = mpfr_get_d (from->real, round);
+      break;
+    }
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    switch (type)
+    {
+    case UCL_REG_TYPE_WORD:
+      if (!isfinite (from->dbl))
+      {
+        reg->type = UCL_REG_TYPE_DOUBLE;
+        reg->dbl = from->dbl;
+      }
+      else
+      if (trunc (from->dbl) >= (gdouble) G_MINLONG
+        && trunc (from->dbl) < - (gdouble) G_MINLONG)
+        reg->word = (glong) from->dbl;
+      else
+      {
+        reg->type = UCL_REG_TYPE_INTEGER;
+        mpz_init_set_d (reg->integer, from->dbl);
+      }
+      break;
+    case UCL_REG_TYPE_INTEGER:
+      mpz_init_set_d (reg->integer, from->dbl);
+      break;
+    case UCL_REG_TYPE_RATIONAL:
+      mpq_init (reg->rational);
+      mpq_set_d (reg->rational, from->dbl);
+      break;
+    case UCL_REG_TYPE_REAL:
+      _ucl_mpfr_init (reg->real);
+      mpfr_set_d (reg->real, from->dbl, round);
+      break;
     }
     break;
   }
@@ -171,6 +289,13 @@ ucl_reg_setup (UclReg* reg, UclRegType type)
     _reg_unset (reg);
     _reg_setup (reg, type);
   }
+  else
+  if (type == UCL_REG_TYPE_REAL)
+  {
+    mpfr_prec_t prec = _ucl_context_precision ();
+    if (mpfr_get_prec (reg->real) != prec)
+      mpfr_set_prec (reg->real, prec);
+  }
 }
 
 void
@@ -222,6 +347,12 @@ ucl_reg_copy (UclReg* reg, const UclReg* from)
   case UCL_REG_TYPE_POINTER:
     reg->pointer = from->pointer;
     break;
+  case UCL_REG_TYPE_WORD:
+    reg->word = from->word;
+    break;
+  case UCL_REG_TYPE_DOUBLE:
+    reg->dbl = from->dbl;
+    break;
   case UCL_REG_TYPE_INTEGER:
     mpz_set (reg->integer, from->integer);
     break;
@@ -221,7 +221,7 @@ disassemble (GBytes* bytes)
       switch (opcode->code)
       {
       case B_OPCODE_MOVE:
-        g_string_append_printf (buf, " %u %u", (guint) opcode->abc.a, (guint) opcode->abc.b);
+        g_string_append_printf (buf, " %u %u %u", (guint) opcode->abc.a, (guint) opcode->abc.b, (guint) opcode->abc.c);
         break;
       case B_OPCODE_LOADK:
         g_string_append_printf (buf, " %u %u", (guint) opcode->abx.a, (guint) opcode->abx.bx);
@@ -0,0 +1,257 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <libabaco.h>
+#include <lexer.h>
+#include <glib.h>
+#include <string.h>
+
+#define _g_object_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
+#define _g_free0(var) ((var == NULL) ? NULL : (var = (g_free (var), NULL)))
+
+/*
+ * Splits 'input' into 'token:class' pairs
+ *
+ */
+
+static gchar*
+tokenize (Lexer* lexer, const gchar* input)
+{
+  GString* buf = g_string_sized_new (64);
+  gsize size, length = strlen (input);
+  gint klass;
+
+  while ((size = _lexer_next (lexer, input, length, &klass)) > 0)
+  {
+    if (buf->len > 0)
+      g_string_append_c (buf, ' ');
+    g_string_append_printf (buf, "%.*s:%i", (int) size, input, klass);
+    input += size;
+    length -= size;
+  }
+return g_string_free (buf, FALSE);
+}
+
+static Lexer*
+lexer_new (const gchar** tokens, const gchar** classes)
+{
+  Lexer* lexer = _lexer_new ();
+
+  for (; *tokens != NULL; tokens++)
+    g_assert_true (_lexer_add_token (lexer, *tokens));
+  for (; *classes != NULL; classes++)
+    g_assert_true (_lexer_add_class (lexer, *classes));
+return lexer;
+}
+
+static void
+check (const gchar** tokens, const gchar** classes, const gchar* input, const gchar* expected)
+{
+  Lexer* lexer = lexer_new (tokens, classes);
+  gchar* got = tokenize (lexer, input);
+
+  g_assert_cmpstr (got, ==, expected);
+  _lexer_free (lexer);
+  g_free (got);
+}
+
+static void
+test_sets (void)
+{
+  const gchar* tokens [] = { "[0-9]+", "[a-c]", NULL, };
+  const gchar* classes [] = { "[0-9]", "[abc]", NULL, };
+  check (tokens, classes, "12ab3c", "12:0 a:1 b:1 3:0 c:1");
+}
+
+static void
+test_negated_sets (void)
+{
+  const gchar* tokens [] = { "[^a-z]", "[a-z]+", NULL, };
+  const gchar* classes [] = { "[a-z]", "[^a-z]", NULL, };
+  check (tokens, classes, "ab+cd--e", "ab:0 +:1 cd:0 -:1 -:1 e:0");
+}
+
+static void
+test_properties (void)
+{
+  const gchar* tokens [] = { "[\\p{L}]", "[\\p{N}]+", "\\P{L}", NULL, };
+  const gchar* classes [] = { "\\p{L}", "\\p{N}", ".*", NULL, };
+  check (tokens, classes, "xα12β+", "x:0 α:0 12:1 β:0 +:2");
+}
+
+static void
+test_alternation (void)
+{
+  const gchar* tokens [] = { "sinh|sin|s", "[a-z]", NULL, };
+  const gchar* classes [] = { "sin", "s", ".*", NULL, };
+  check (tokens, classes, "sinhsinsx", "sinh:0 sin:0 s:1 x:2");
+}
+
+static void
+test_quantifiers (void)
+{
+  const gchar* tokens [] = { "ab*c", "x+", "y?z", "(uv)*w", NULL, };
+  const gchar* classes [] = { "a", "x", "z", "w", NULL, };
+  check (tokens, classes, "acabbbcxxxzyzuvuvw", "ac:0 abbbc:0 xxx:1 z:2 yz:2 uvuvw:3");
+}
+
+static void
+test_priority (void)
+{
+  /* the first rule matching at all wins, with its longest match */
+  const gchar* tokens [] = { "[\\+]", "[a-z]", "[a-z\\+]+", NULL, };
+  const gchar* classes [] = { ".*", NULL, };
+  check (tokens, classes, "+ab+", "+:0 a:0 b:0 +:0");
+
+  const gchar* tokens2 [] = { "ab", "a[a-z]*", NULL, };
+  check (tokens2, classes, "abc", "ab:0 c:0");
+}
+
+static void
+test_unmatched (void)
+{
+  /* runs no rule matches become one token */
+  const gchar* tokens [] = { "[0-9]+", NULL, };
+  const gchar* classes [] = { "[0-9]", NULL, };
+  check (tokens, classes, "12ñó3", "12:0 ñó:-1 3:0");
+}
+
+static void
+test_unsupported (void)
+{
+  const gchar* patterns [] = { "x{2}", "^x", "x$", "(?=x)x", "\\bx", "[x", "(x", NULL, };
+  const gchar** pattern;
+
+  for (pattern = patterns; *pattern != NULL; pattern++)
+  {
+    Lexer* lexer = _lexer_new ();
+    g_assert_false (_lexer_add_token (lexer, *pattern));
+    _lexer_free (lexer);
+  }
+}
+
+/*
+ * Rules go back to GRegex as soon as any of its
+ * patterns is beyond the lexer; both paths must
+ * build the same trees for the default rules
+ *
+ */
+
+static void
+print_tree (AbacoAstNode* node, GString* buf)
+{
+  guint i, n_children = abaco_ast_node_n_children (node);
+
+  g_string_append_printf (buf, "(%s:%i", abaco_ast_node_get_symbol (node), abaco_ast_node_get_kind (node));
+  for (i = 0; i < n_children; i++)
+  {
+    g_string_append_c (buf, ' ');
+    print_tree (abaco_ast_node_nth_child (node, i), buf);
+  }
+  g_string_append_c (buf, ')');
+}
+
+static AbacoRules*
+rules_new (gboolean fallback)
+{
+  AbacoRules* rules = abaco_rules_new ();
+  GError* tmp_err = NULL;
+
+  abaco_rules_add_operator (rules, "[\\+]", FALSE, 2, FALSE, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_operator (rules, "[\\-]", FALSE, 2, FALSE, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_operator (rules, "[\\*]", FALSE, 3, FALSE, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_operator (rules, "[\\/]", FALSE, 3, FALSE, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_operator (rules, "[\\^]",  TRUE, 4, FALSE, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_function (rules, "sin", 1, &tmp_err);
+    g_assert_no_error (tmp_err);
+  abaco_rules_add_function (rules, "max", 2, &tmp_err);
+    g_assert_no_error (tmp_err);
+
+  if (fallback)
+  {
+    /* never matches below, but the lexer can't take it */
+    abaco_rules_add_constant (rules, "q{3}", &tmp_err);
+      g_assert_no_error (tmp_err);
+  }
+return rules;
+}
+
+static gchar*
+parse (AbacoRules* rules, const gchar* input)
+{
+  GString* buf = g_string_sized_new (64);
+  GError* tmp_err = NULL;
+  AbacoAstNode* tree = NULL;
+
+  tree = abaco_rules_parse (rules, input, -1, &tmp_err);
+  g_assert_no_error (tmp_err);
+  print_tree (tree, buf);
+  abaco_ast_node_unref (tree);
+return g_string_free (buf, FALSE);
+}
+
+static void
+test_fallback (void)
+{
+  AbacoRules* lexer = rules_new (FALSE);
+  AbacoRules* regex = rules_new (TRUE);
+  const gchar* inputs [] =
+  {
+    "1+2*3",
+    "sin(x)^2+max(1.5,y)/3",
+    "(a-b)*c",
+    "α*β+12.25",
+    "max(sin(2*x),0.5)",
+    NULL,
+  };
+
+  const gchar** input;
+  for (input = inputs; *input != NULL; input++)
+  {
+    gchar* expected = parse (regex, *input);
+    gchar* got = parse (lexer, *input);
+
+    g_assert_cmpstr (got, ==, expected);
+    _g_free0 (expected);
+    _g_free0 (got);
+  }
+
+  _g_object_unref0 (lexer);
+  _g_object_unref0 (regex);
+}
+
+int
+main (int argc, char* argv [])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/lexer/sets", test_sets);
+  g_test_add_func ("/lexer/negated-sets", test_negated_sets);
+  g_test_add_func ("/lexer/properties", test_properties);
+  g_test_add_func ("/lexer/alternation", test_alternation);
+  g_test_add_func ("/lexer/quantifiers", test_quantifiers);
+  g_test_add_func ("/lexer/priority", test_priority);
+  g_test_add_func ("/lexer/unmatched", test_unmatched);
+  g_test_add_func ("/lexer/unsupported", test_unsupported);
+  g_test_add_func ("/lexer/fallback", test_fallback);
+return g_test_run ();
+}
@@ -23,14 +23,76 @@
 
 const gchar* output = NULL;
 const gchar* execute = NULL;
+gboolean arena = FALSE;
 gboolean benchmark = FALSE;
+gboolean fast = FALSE;
+gboolean parameterize = FALSE;
 
 #define _g_free0(var) ((var == NULL) ? NULL : (var = (g_free (var), NULL)))
 
 static inline void
-do_report (AbacoVM* vm, AbacoMP* mp, const gchar* code)
+do_benchmark (AbacoVM* vm, AbacoMP* mp, const gchar* code, const gchar* engine)
 {
+  const gdouble spt = (gdouble) CLOCKS_PER_SEC;
+  const gdouble mpt = spt / (gdouble) 1000;
+  const int tries = 100000;
+  const int reps = 10;
+  gdouble partial = 0;
   GString* buffer = NULL;
+  gchar* result = NULL;
+  gchar* last = NULL;
+  clock_t src, dst;
+  int i, j;
+
+  buffer = g_string_sized_new (128);
+
+  g_print ("trying with %i cycles, %i times (%s dispatch)\r\n", tries, reps, engine);
+
+  for (i = 0; i < reps; i++)
+  {
+    for (j = 0; j < tries; j++)
+    {
+      abaco_vm_pushvalue (vm, 0);
+      src = clock ();
+      abaco_vm_call (vm, 0);
+      dst = clock ();
+
+      if (j == 0)
+      {
+        partial = (gdouble) (dst - src);
+        last = abaco_mp_tostring (mp, -1, 10);
+      }
+      else
+      {
+        result = abaco_mp_tostring (mp, -1, 10);
+        if (g_strcmp0 (result, last))
+          g_error ("Results differs");
+        else
+          _g_free0 (result);
+
+        partial += (gdouble) (dst - src);
+        partial /= 2;
+      }
+    }
+
+    abaco_vm_settop (vm, 1);
+    g_string_append_printf (buffer, "> '%s'", code);
+    g_string_append_printf (buffer, " = '%s'", last);
+    g_string_append_printf (buffer, " (took ");
+    g_string_append_printf (buffer, "%lf ticks, ", partial);
+    g_string_append_printf (buffer, "%lf micros, ", partial / mpt);
+    g_string_append_printf (buffer, "%lf seconds)", partial / spt);
+    g_print ("%.*s\r\n", buffer->len, buffer->str);
+    g_string_truncate (buffer, 0);
+    _g_free0 (last);
+  }
+
+  g_string_free (buffer, TRUE);
+}
+
+static inline void
+do_report (AbacoVM* vm, AbacoMP* mp, const gchar* code)
+{
   GError* tmp_err = NULL;
   gchar* result = NULL;
 
@@ -68,60 +130,17 @@ do_report (AbacoVM* vm, AbacoMP* mp, const gchar* code)
   }
   else
   {
-    const gdouble spt = (gdouble) CLOCKS_PER_SEC;
-    const gdouble mpt = spt / (gdouble) 1000;
-    const int tries = 100000;
-    const int reps = 10;
-    gdouble partial = 0;
-    gchar* result = NULL;
-    gchar* last = NULL;
-    clock_t src, dst;
-    int i, j;
-
-    buffer = g_string_sized_new (128);
-
-    g_print ("trying with %i cycles, %i times\r\n", tries, reps);
+    gboolean threaded = FALSE;
 
-    for (i = 0; i < reps; i++)
-    {
-      for (j = 0; j < tries; j++)
-      {
-        abaco_vm_pushvalue (vm, 0);
-        src = clock ();
-        abaco_vm_call (vm, 0);
-        dst = clock ();
-
-        if (j == 0)
-        {
-          partial = (gdouble) (dst - src);
-          last = abaco_mp_tostring (mp, -1, 10);
-        }
-        else
-        {
-          result = abaco_mp_tostring (mp, -1, 10);
-          if (g_strcmp0 (result, last))
-            g_error ("Results differs");
-          else
-            _g_free0 (result);
-
-          partial += (gdouble) (dst - src);
-          partial /= 2;
-        }
-      }
+    g_object_set (vm, "threaded", FALSE, NULL);
+    do_benchmark (vm, mp, code, "switch");
+    g_object_set (vm, "threaded", TRUE, NULL);
+    g_object_get (vm, "threaded", &threaded, NULL);
 
-      abaco_vm_settop (vm, 1);
-      g_string_append_printf (buffer, "> '%s'", code);
-      g_string_append_printf (buffer, " = '%s'", last);
-      g_string_append_printf (buffer, " (took ");
-      g_string_append_printf (buffer, "%lf ticks, ", partial);
-      g_string_append_printf (buffer, "%lf micros, ", partial / mpt);
-      g_string_append_printf (buffer, "%lf seconds)", partial / spt);
-      g_print ("%.*s\r\n", buffer->len, buffer->str);
-      g_string_truncate (buffer, 0);
-      _g_free0 (last);
-    }
-
-    g_string_free (buffer, TRUE);
+    if (threaded)
+      do_benchmark (vm, mp, code, "threaded");
+    else
+      g_print ("threaded dispatch not available\r\n");
   }
 }
 
@@ -133,9 +152,12 @@ main (int argc, char* argv [])
 
   GOptionEntry entries[] =
   {
+    { "arena", 0, 0, G_OPTION_ARG_NONE, &arena, NULL, NULL },
     { "benchmark", 0, 0, G_OPTION_ARG_NONE, &benchmark, NULL, NULL },
     { "execute", 'e', 0, G_OPTION_ARG_STRING, &execute, NULL, "CODE" },
+    { "fast", 0, 0, G_OPTION_ARG_NONE, &fast, NULL, NULL },
     { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, NULL, "FILE" },
+    { "parameterize", 0, 0, G_OPTION_ARG_NONE, &parameterize, NULL, NULL },
     { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL },
   };
 
@@ -165,6 +187,8 @@ main (int argc, char* argv [])
     AbacoVM* vm = abaco_mp_new ();
     AbacoMP* mp = ABACO_MP (vm);
 
+    g_object_set (vm, "fast", fast, "arena", arena, "parameterize", parameterize, NULL);
+
     if (execute != NULL)
     {
       abaco_vm_loadstring (vm, execute, &tmp_err);
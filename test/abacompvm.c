@@ -0,0 +1,190 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <libabaco.h>
+#include <libabaco_mp.h>
+#include <glib.h>
+#include <math.h>
+
+#define _g_object_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
+#define _g_free0(var) ((var == NULL) ? NULL : (var = (g_free (var), NULL)))
+
+static AbacoVM*
+load (const gchar* code)
+{
+  AbacoVM* vm = abaco_mp_new ();
+  GError* tmp_err = NULL;
+
+  abaco_vm_loadstring (vm, code, &tmp_err);
+  g_assert_no_error (tmp_err);
+return vm;
+}
+
+/*
+ * Runs 'code' over 'args' (pushed as strings)
+ * and returns the result as a string
+ *
+ */
+
+static gchar*
+run (const gchar* code, const gchar** args)
+{
+  AbacoVM* vm = load (code);
+  AbacoMP* mp = ABACO_MP (vm);
+  gchar* result = NULL;
+  gint n_args = 0;
+
+  for (; args != NULL && *args != NULL; args++, n_args++)
+    g_assert_true (abaco_mp_pushstring (mp, *args, 10));
+
+  g_assert_cmpint (abaco_vm_call (vm, n_args), ==, 1);
+  result = abaco_mp_tostring (mp, -1, 10);
+  _g_object_unref0 (vm);
+return result;
+}
+
+static void
+check (const gchar* code, const gchar** args, const gchar* expected)
+{
+  gchar* got = run (code, args);
+
+  g_assert_cmpstr (got, ==, expected);
+  _g_free0 (got);
+}
+
+static void
+test_rootn (void)
+{
+  const gchar* args1 [] = { "-8", "3", NULL, };
+  const gchar* args2 [] = { "1", "10000000000000000000", NULL, };
+
+  check ("rootn(27,3)", NULL, "3");
+  check ("rootn(x,y)", args1, "-2");
+  check ("rootn(4/9,2)", NULL, "2/3");
+
+  /* degrees past a word still fit an unsigned long */
+  check ("rootn(1,10000000000000000000)", NULL, "1");
+  check ("rootn(x,y)", args2, "1");
+}
+
+static void
+test_rows_columns (void)
+{
+  AbacoVM* vm = load ("x*y");
+  AbacoMP* mp = ABACO_MP (vm);
+  gint64 xs [] = { 1, 2, };
+  gint64 results [G_N_ELEMENTS (xs)];
+  AbacoMPColumn columns [] = { { ABACO_MP_COLUMN_INT64, xs, }, };
+  AbacoMPColumn result = { ABACO_MP_COLUMN_INT64, results, };
+  GError* tmp_err = NULL;
+
+  /* one column short, so 'y' would be stale */
+  g_assert_false (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, G_N_ELEMENTS (xs), &tmp_err));
+  g_assert_error (tmp_err, ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED);
+  g_clear_error (&tmp_err);
+  _g_object_unref0 (vm);
+}
+
+static void
+test_rows_integers (void)
+{
+  AbacoVM* vm = load ("x*y");
+  AbacoMP* mp = ABACO_MP (vm);
+  gint64 xs [] = { 2, -3, G_MAXINT64, };
+  gint64 ys [] = { 5, 7, 2, };
+  gint64 results [G_N_ELEMENTS (xs)];
+  AbacoMPColumn columns [] = { { ABACO_MP_COLUMN_INT64, xs, }, { ABACO_MP_COLUMN_INT64, ys, }, };
+  AbacoMPColumn result = { ABACO_MP_COLUMN_INT64, results, };
+  GError* tmp_err = NULL;
+
+  g_assert_true (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, 2, &tmp_err));
+  g_assert_no_error (tmp_err);
+  g_assert_cmpint (results [0], ==, 10);
+  g_assert_cmpint (results [1], ==, -21);
+
+  /* the last product overflows the column */
+  g_assert_false (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, G_N_ELEMENTS (xs), &tmp_err));
+  g_assert_error (tmp_err, ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED);
+  g_assert_true (g_str_has_prefix (tmp_err->message, "Row 2:"));
+  g_clear_error (&tmp_err);
+  _g_object_unref0 (vm);
+}
+
+static void
+test_rows_reals (void)
+{
+  AbacoVM* vm = load ("x*y");
+  AbacoMP* mp = ABACO_MP (vm);
+  gdouble xs [] = { 2.5, 1e300, 0, };
+  gdouble ys [] = { 2, 1e10, INFINITY, };
+  gint64 results [G_N_ELEMENTS (xs)];
+  AbacoMPColumn columns [] = { { ABACO_MP_COLUMN_DOUBLE, xs, }, { ABACO_MP_COLUMN_DOUBLE, ys, }, };
+  AbacoMPColumn result = { ABACO_MP_COLUMN_INT64, results, };
+  GError* tmp_err = NULL;
+
+  /* too large for the column */
+  g_assert_false (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, 2, &tmp_err));
+  g_assert_error (tmp_err, ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED);
+  g_assert_true (g_str_has_prefix (tmp_err->message, "Row 1:"));
+  g_assert_cmpint (results [0], ==, 5);
+  g_clear_error (&tmp_err);
+
+  /* not a number at all */
+  columns [0].data = & xs [2];
+  columns [1].data = & ys [2];
+  g_assert_false (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, 1, &tmp_err));
+  g_assert_error (tmp_err, ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED);
+  g_assert_true (g_str_has_prefix (tmp_err->message, "Row 0:"));
+  g_clear_error (&tmp_err);
+  _g_object_unref0 (vm);
+}
+
+static void
+test_rows_strings (void)
+{
+  AbacoVM* vm = load ("x+y");
+  AbacoMP* mp = ABACO_MP (vm);
+  const gchar* xs [] = { "1/2", "z", };
+  const gchar* ys [] = { "1", "2", };
+  gchar* results [G_N_ELEMENTS (xs)] = { NULL, };
+  AbacoMPColumn columns [] = { { ABACO_MP_COLUMN_STRING, xs, }, { ABACO_MP_COLUMN_STRING, ys, }, };
+  AbacoMPColumn result = { ABACO_MP_COLUMN_STRING, results, };
+  GError* tmp_err = NULL;
+
+  g_assert_false (abaco_mp_call_rows (mp, -1, columns, G_N_ELEMENTS (columns), &result, G_N_ELEMENTS (xs), &tmp_err));
+  g_assert_error (tmp_err, ABACO_MP_ERROR, ABACO_MP_ERROR_FAILED);
+  g_assert_true (g_str_has_prefix (tmp_err->message, "Row 1:"));
+  g_assert_cmpstr (results [0], ==, "3/2");
+  g_assert_null (results [1]);
+  g_clear_error (&tmp_err);
+
+  _g_free0 (results [0]);
+  _g_object_unref0 (vm);
+}
+
+int
+main (int argc, char* argv [])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/mp/rootn", test_rootn);
+  g_test_add_func ("/mp/rows/columns", test_rows_columns);
+  g_test_add_func ("/mp/rows/integers", test_rows_integers);
+  g_test_add_func ("/mp/rows/reals", test_rows_reals);
+  g_test_add_func ("/mp/rows/strings", test_rows_strings);
+return g_test_run ();
+}
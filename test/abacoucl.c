@@ -0,0 +1,345 @@
+/* Copyright 2021-2025 MarcosHCK
+ * This file is part of libabaco.
+ *
+ * libabaco is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libabaco is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libabaco.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <libabaco_ucl.h>
+#include <math.h>
+
+/*
+ * Registers are set up by hand, in a default
+ * (non-fast, 53-bit) context
+ *
+ */
+
+static void
+setup_word (UclReg* reg, glong value)
+{
+  ucl_reg_setup (reg, UCL_REG_TYPE_WORD);
+  reg->word = value;
+}
+
+static void
+setup_rational (UclReg* reg, glong num, gulong den)
+{
+  ucl_reg_setup (reg, UCL_REG_TYPE_RATIONAL);
+  mpq_set_si (reg->rational, num, den);
+  mpq_canonicalize (reg->rational);
+}
+
+static void
+setup_double (UclReg* reg, gdouble value)
+{
+  ucl_reg_setup (reg, UCL_REG_TYPE_DOUBLE);
+  reg->dbl = value;
+}
+
+static void
+setup_real (UclReg* reg, gdouble value)
+{
+  ucl_reg_setup (reg, UCL_REG_TYPE_REAL);
+  mpfr_set_d (reg->real, value, MPFR_RNDN);
+}
+
+static void
+assert_integer (const UclReg* reg, const gchar* expected)
+{
+  mpz_t z;
+
+  g_assert_cmpint (reg->type, ==, UCL_REG_TYPE_INTEGER);
+  mpz_init_set_str (z, expected, 10);
+  g_assert_cmpint (mpz_cmp (reg->integer, z), ==, 0);
+  mpz_clear (z);
+}
+
+static void
+test_load_decimal (void)
+{
+  UclReg reg = {0};
+
+  /* '12.5' once loaded as 1.25 */
+  g_assert_true (ucl_reg_load_string (&reg, "12.5", 10));
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_RATIONAL);
+  g_assert_cmpint (mpq_cmp_si (reg.rational, 25, 2), ==, 0);
+
+  g_assert_true (ucl_reg_load_string (&reg, "-0.125", 10));
+  g_assert_cmpint (mpq_cmp_si (reg.rational, -1, 8), ==, 0);
+
+  g_assert_true (ucl_reg_load_string (&reg, "100.", 10));
+  g_assert_cmpint (mpq_cmp_si (reg.rational, 100, 1), ==, 0);
+
+  /* too many digits for a word */
+  g_assert_true (ucl_reg_load_string (&reg, "12345678901234567890.5", 10));
+  {
+    mpq_t q;
+    mpq_init (q);
+    mpq_set_str (q, "24691357802469135781/2", 10);
+    g_assert_true (mpq_equal (reg.rational, q));
+    mpq_clear (q);
+  }
+
+  ucl_reg_unset (&reg);
+}
+
+static void
+test_load_fraction (void)
+{
+  UclReg reg = {0};
+
+  g_assert_true (ucl_reg_load_string (&reg, "6/4", 10));
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_RATIONAL);
+  g_assert_cmpint (mpq_cmp_si (reg.rational, 3, 2), ==, 0);
+
+  /* zero denominators fail instead of trapping */
+  g_assert_false (ucl_reg_load_string (&reg, "1/0", 10));
+  g_assert_false (ucl_reg_load_string (&reg, "0/0", 10));
+  g_assert_false (ucl_reg_load_string (&reg, "123456789012345678901234567890/0", 10));
+  g_assert_false (ucl_reg_load_string (&reg, "1/", 10));
+
+  ucl_reg_unset (&reg);
+}
+
+static void
+test_word_promotion (void)
+{
+  UclReg accum = {0}, next = {0};
+
+  g_assert_true (ucl_reg_load_string (&accum, "42", 10));
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (accum.word, ==, 42);
+
+  g_assert_true (ucl_reg_load_string (&accum, "123456789012345678901234567890", 10));
+  assert_integer (&accum, "123456789012345678901234567890");
+
+  setup_word (&accum, G_MAXLONG);
+  setup_word (&next, 1);
+  ucl_arithmetic_add (&accum, &next);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_INTEGER);
+  g_assert_cmpint (mpz_cmp_si (accum.integer, G_MAXLONG), >, 0);
+  g_assert_false (mpz_fits_slong_p (accum.integer));
+
+  setup_word (&accum, G_MINLONG);
+  setup_word (&next, 1);
+  ucl_arithmetic_sub (&accum, &next);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_INTEGER);
+  g_assert_cmpint (mpz_cmp_si (accum.integer, G_MINLONG), <, 0);
+
+  setup_word (&accum, G_MAXLONG);
+  setup_word (&next, 2);
+  ucl_arithmetic_mul (&accum, &next);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_INTEGER);
+  g_assert_cmpint (mpz_sizeinbase (accum.integer, 2), ==, sizeof (glong) * 8);
+
+  /* no overflow, no promotion */
+  setup_word (&accum, 6);
+  setup_word (&next, 7);
+  ucl_arithmetic_mul (&accum, &next);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (accum.word, ==, 42);
+
+  ucl_reg_unset (&accum);
+  ucl_reg_unset (&next);
+}
+
+static void
+test_word_cast (void)
+{
+  UclReg reg = {0}, word = {0};
+
+  /* values out of a word's range stay wide */
+  g_assert_true (ucl_reg_load_string (&reg, "123456789012345678901234567890", 10));
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  assert_integer (&word, "123456789012345678901234567890");
+  ucl_reg_unset (&word);
+
+  setup_double (&reg, 1e30);
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  assert_integer (&word, "1000000000000000019884624838656");
+  ucl_reg_unset (&word);
+
+  setup_double (&reg, NAN);
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.type, ==, UCL_REG_TYPE_DOUBLE);
+  ucl_reg_unset (&word);
+
+  setup_real (&reg, -INFINITY);
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.type, ==, UCL_REG_TYPE_REAL);
+  ucl_reg_unset (&word);
+
+  setup_rational (&reg, -7, 2);
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.word, ==, -3);
+  ucl_reg_unset (&word);
+
+  setup_double (&reg, -2.75);
+  ucl_reg_cast (&word, &reg, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (word.word, ==, -2);
+  ucl_reg_unset (&word);
+
+  ucl_reg_unset (&reg);
+}
+
+static void
+test_fma_exact (void)
+{
+  UclReg accum = {0}, a = {0}, b = {0};
+
+  setup_word (&accum, G_MAXLONG);
+  setup_word (&a, 2);
+  setup_word (&b, 3);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_INTEGER);
+  g_assert_cmpint (mpz_cmp_si (accum.integer, G_MAXLONG), >, 0);
+  mpz_sub_ui (accum.integer, accum.integer, 6);
+  g_assert_cmpint (mpz_cmp_si (accum.integer, G_MAXLONG), ==, 0);
+
+  setup_rational (&accum, 1, 2);
+  setup_rational (&a, 1, 3);
+  setup_word (&b, 3);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_RATIONAL);
+  g_assert_cmpint (mpq_cmp_si (accum.rational, 3, 2), ==, 0);
+
+  /* an empty accumulator takes the product */
+  ucl_reg_unset (&accum);
+  setup_word (&a, 6);
+  setup_word (&b, 7);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (accum.word, ==, 42);
+
+  ucl_reg_unset (&accum);
+  ucl_reg_unset (&a);
+  ucl_reg_unset (&b);
+}
+
+static void
+test_fma_rounding (void)
+{
+  UclReg accum = {0}, a = {0}, b = {0};
+
+  /*
+   * 1/3 * 3 - 1 is exactly zero; rounding 1/3 before
+   * the fused operation would leave a residue
+   *
+   */
+
+  setup_real (&accum, -1);
+  setup_rational (&a, 1, 3);
+  setup_real (&b, 3);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_REAL);
+  g_assert_true (mpfr_zero_p (accum.real));
+
+  setup_double (&accum, -1);
+  setup_rational (&a, 1, 3);
+  setup_double (&b, 3);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_DOUBLE);
+  g_assert_cmpfloat (accum.dbl, ==, 0);
+
+  setup_rational (&accum, -1, 1);
+  setup_real (&a, 0.5);
+  setup_rational (&b, 2, 1);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpint (accum.type, ==, UCL_REG_TYPE_REAL);
+  g_assert_true (mpfr_zero_p (accum.real));
+
+  /* doubles fuse */
+  setup_double (&accum, -1);
+  setup_double (&a, 1 + 0x1p-30);
+  setup_double (&b, 1 - 0x1p-30);
+  ucl_arithmetic_fma (&accum, &a, &b);
+  g_assert_cmpfloat (accum.dbl, ==, -0x1p-60);
+
+  ucl_reg_unset (&accum);
+  ucl_reg_unset (&a);
+  ucl_reg_unset (&b);
+}
+
+static void
+test_fma_accum (void)
+{
+  if (g_test_subprocess ())
+  {
+    UclReg accum = {0}, a = {0}, b = {0};
+
+    ucl_reg_setup (&accum, UCL_REG_TYPE_POINTER);
+    setup_word (&a, 2);
+    setup_word (&b, 3);
+    ucl_arithmetic_fma (&accum, &a, &b);
+    return;
+  }
+
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+  g_test_trap_assert_stderr ("*numeric value*");
+}
+
+static void
+test_roots (void)
+{
+  UclReg reg = {0};
+
+  setup_word (&reg, 27);
+  ucl_power_rootn (&reg, 3);
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (reg.word, ==, 3);
+
+  setup_word (&reg, -8);
+  ucl_power_cbrt (&reg);
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_WORD);
+  g_assert_cmpint (reg.word, ==, -2);
+
+  g_assert_true (ucl_reg_load_string (&reg, "1606938044258990275541962092341162602522202993782792835301376", 10));
+  ucl_power_rootn (&reg, 200);
+  assert_integer (&reg, "2");
+
+  setup_rational (&reg, 4, 9);
+  ucl_power_sqrt (&reg);
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_RATIONAL);
+  g_assert_cmpint (mpq_cmp_si (reg.rational, 2, 3), ==, 0);
+
+  /* inexact roots leave exact types */
+  setup_word (&reg, 2);
+  ucl_power_sqrt (&reg);
+  g_assert_cmpint (reg.type, ==, UCL_REG_TYPE_REAL);
+  g_assert_cmpint (mpfr_cmp_d (reg.real, sqrt (2)), ==, 0);
+
+  setup_double (&reg, -27);
+  ucl_power_rootn (&reg, 3);
+  g_assert_cmpfloat (reg.dbl, ==, -3);
+
+  ucl_reg_unset (&reg);
+}
+
+int
+main (int argc, char* argv [])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/ucl/load/decimal", test_load_decimal);
+  g_test_add_func ("/ucl/load/fraction", test_load_fraction);
+  g_test_add_func ("/ucl/word/promotion", test_word_promotion);
+  g_test_add_func ("/ucl/word/cast", test_word_cast);
+  g_test_add_func ("/ucl/fma/exact", test_fma_exact);
+  g_test_add_func ("/ucl/fma/rounding", test_fma_rounding);
+  g_test_add_func ("/ucl/fma/accum", test_fma_accum);
+  g_test_add_func ("/ucl/roots", test_roots);
+return g_test_run ();
+}